@@ -0,0 +1,27 @@
+# Writes every file in SHADER_DIR into OUTPUT as string constants, so the
+# built-in shaders ship inside the kern library. Runs at build time:
+#   cmake -DSHADER_DIR=<dir> -DOUTPUT=<header> -P EmbedShaders.cmake
+
+file(GLOB shaders "${SHADER_DIR}/*")
+list(SORT shaders)
+
+set(content "// Generated from src/shaders/OpenGL by cmake/EmbedShaders.cmake, do not edit\n")
+string(APPEND content "#pragma once\n\n#include <string_view>\n\nnamespace kern::builtin\n{\n")
+string(APPEND content "    struct EmbeddedShader\n    {\n        std::string_view name;\n        std::string_view source;\n    };\n\n")
+string(APPEND content "    inline constexpr EmbeddedShader shaders[] = {\n")
+
+foreach(shader ${shaders})
+    get_filename_component(name "${shader}" NAME)
+    file(READ "${shader}" source)
+    string(APPEND content "        { \"${name}\", R\"kern_shader(${source})kern_shader\" },\n")
+endforeach()
+
+string(APPEND content "    };\n}\n")
+
+# Only touch the header when a shader changed, so unrelated builds don't recompile
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+endif()
+if(NOT "${previous}" STREQUAL "${content}")
+    file(WRITE "${OUTPUT}" "${content}")
+endif()
@@ -21,7 +21,7 @@ int main()
             .add<kern::Vector3>("a_Position")
     );
 
-    std::vector<Vertex> cube = {
+    std::vector<Vertex> cubeVertices = {
         // front
         {{-0.5f,-0.5f, 0.5f}},
         {{0.5f,-0.5f, 0.5f}},
@@ -71,6 +71,10 @@ int main()
         {{0.5f,-0.5f,-0.5f}}
     };
 
+    // Welded to 8 vertices + 36 indices, uploaded once, drawn by handle every frame
+    kern::Mesh cube = kern::createOptimizedMesh(cubeVertices, shader.getVertexLayout());
+    kern::UniformHandle mvp = shader.uniform("u_MVP");
+
     while (window.isOpen())
     {
         window.clear();
@@ -93,7 +97,7 @@ int main()
             0.1f, 100.0f
         );
 
-        shader.setMat4("u_MVP", proj * view * model);
+        shader.setMat4(mvp, proj * view * model);
         window.draw(cube, shader);
 
         window.present();
@@ -0,0 +1,107 @@
+#include "kern.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+struct Vertex
+{
+    kern::Vector3 pos;
+};
+
+struct Instance
+{
+    kern::Mat4 model;
+    kern::Color color;
+};
+
+int main()
+{
+    kern::Window window =
+        kern::initWindow(1280, 720, "Kern - Command Lists");
+
+    auto shader = kern::createShader(
+        "examples/instanced.vert",
+        "examples/instanced.frag"
+    );
+
+    shader.setVertexLayout(
+        kern::VertexLayout{}
+            .add<kern::Vector3>("a_Position")
+            .addInstanced<kern::Mat4>("i_Model")
+            .addInstanced<kern::Color>("i_Color")
+    );
+
+    std::vector<Vertex> cubeVertices;
+    const float s = 0.5f;
+    const kern::Vector3 corners[8] = {
+        {-s,-s, s}, { s,-s, s}, { s, s, s}, {-s, s, s},
+        {-s,-s,-s}, { s,-s,-s}, { s, s,-s}, {-s, s,-s}
+    };
+    const int faces[36] = {
+        0,1,2, 2,3,0,  5,4,7, 7,6,5,  4,0,3, 3,7,4,
+        1,5,6, 6,2,1,  3,2,6, 6,7,3,  4,5,1, 1,0,4
+    };
+    for (int i : faces)
+        cubeVertices.push_back({ corners[i] });
+
+    kern::Mesh cube = kern::createOptimizedMesh(cubeVertices, shader.getVertexLayout());
+
+    const int side = 316; // ~100k cubes
+    const unsigned int workers = std::max(1u, std::thread::hardware_concurrency());
+
+    // One list per worker, reused every frame
+    std::vector<kern::CommandList> lists(workers);
+
+    while (window.isOpen())
+    {
+        window.clear();
+        window.clearColor(0.1f, 0.1f, 0.1f);
+
+        float t = window.getTime();
+
+        // Each worker builds the instances for its own rows; no GL calls here
+        std::vector<std::thread> threads;
+        for (unsigned int w = 0; w < workers; w++)
+        {
+            threads.emplace_back([&, w]()
+            {
+                kern::CommandList& list = lists[w];
+                list.reset();
+
+                const int rowBegin = side * w / workers;
+                const int rowEnd = side * (w + 1) / workers;
+                if (rowBegin == rowEnd) return;
+
+                std::span<Instance> instances = list.allocate<Instance>(size_t(rowEnd - rowBegin) * side);
+
+                for (int z = rowBegin; z < rowEnd; z++)
+                {
+                    for (int x = 0; x < side; x++)
+                    {
+                        Instance& instance = instances[size_t(z - rowBegin) * side + x];
+                        float height = std::sin(x * 0.1f + t) * std::cos(z * 0.1f + t) * 2.0f;
+
+                        instance.model = kern::translate(kern::Mat4(1.0f),
+                            glm::vec3((x - side / 2) * 1.5f, height, (z - side / 2) * 1.5f));
+                        instance.color = kern::Color(x / float(side), 0.5f + height * 0.25f, z / float(side));
+                    }
+                }
+
+                list.drawInstanced(cube, std::span<const Instance>(instances), shader);
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+
+        kern::Mat4 view = kern::lookAt({0, 60, 120}, {0, 0, 0}, {0, 1, 0});
+        kern::Mat4 proj = kern::perspective(kern::radians(60.0f), 1280.0f / 720.0f, 0.1f, 1000.0f);
+        window.setCamera(view, proj);
+
+        // Always submitted in worker order, whichever finished first
+        window.submit(lists);
+
+        window.present();
+    }
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 a_Position;
+layout (location = 1) in mat4 i_Model; // locations 1-4
+layout (location = 5) in vec4 i_Color;
+
+layout(std140) uniform KernFrame
+{
+    mat4 u_View;
+    mat4 u_Projection;
+    mat4 u_ViewProjection;
+    vec4 u_Viewport;
+    float u_Time;
+    float u_DeltaTime;
+};
+
+out vec4 v_Color;
+
+void main()
+{
+    gl_Position = u_ViewProjection * i_Model * vec4(a_Position, 1.0);
+    v_Color = i_Color;
+}
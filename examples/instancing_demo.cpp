@@ -0,0 +1,83 @@
+#include "kern.h"
+#include <cmath>
+#include <vector>
+
+struct Vertex
+{
+    kern::Vector3 pos;
+};
+
+struct Instance
+{
+    kern::Mat4 model;
+    kern::Color color;
+};
+
+int main()
+{
+    kern::Window window =
+        kern::initWindow(1280, 720, "Kern - 100k Instances");
+
+    auto shader = kern::createShader(
+        "examples/instanced.vert",
+        "examples/instanced.frag"
+    );
+
+    shader.setVertexLayout(
+        kern::VertexLayout{}
+            .add<kern::Vector3>("a_Position")
+            .addInstanced<kern::Mat4>("i_Model")
+            .addInstanced<kern::Color>("i_Color")
+    );
+
+    std::vector<Vertex> cubeVertices;
+    const float s = 0.5f;
+    const kern::Vector3 corners[8] = {
+        {-s,-s, s}, { s,-s, s}, { s, s, s}, {-s, s, s},
+        {-s,-s,-s}, { s,-s,-s}, { s, s,-s}, {-s, s,-s}
+    };
+    const int faces[36] = {
+        0,1,2, 2,3,0,  5,4,7, 7,6,5,  4,0,3, 3,7,4,
+        1,5,6, 6,2,1,  3,2,6, 6,7,3,  4,5,1, 1,0,4
+    };
+    for (int i : faces)
+        cubeVertices.push_back({ corners[i] });
+
+    kern::Mesh cube = kern::createOptimizedMesh(cubeVertices, shader.getVertexLayout());
+
+    const int side = 316; // ~100k cubes
+    std::vector<Instance> instances(side * side);
+
+    while (window.isOpen())
+    {
+        window.clear();
+        window.clearColor(0.1f, 0.1f, 0.1f);
+
+        float t = window.getTime();
+
+        for (int z = 0; z < side; z++)
+        {
+            for (int x = 0; x < side; x++)
+            {
+                Instance& instance = instances[z * side + x];
+                float height = std::sin(x * 0.1f + t) * std::cos(z * 0.1f + t) * 2.0f;
+
+                instance.model = kern::translate(kern::Mat4(1.0f),
+                    glm::vec3((x - side / 2) * 1.5f, height, (z - side / 2) * 1.5f));
+                instance.color = kern::Color(x / float(side), 0.5f + height * 0.25f, z / float(side));
+            }
+        }
+
+        kern::Mat4 view = kern::lookAt({0, 60, 120}, {0, 0, 0}, {0, 1, 0});
+        kern::Mat4 proj = kern::perspective(kern::radians(60.0f), 1280.0f / 720.0f, 0.1f, 1000.0f);
+        // Shared by every program that declares KernFrame
+        window.setCamera(view, proj);
+
+        // One draw call + one instance upload for the whole field
+        window.drawInstanced(cube, instances, shader);
+
+        window.present();
+    }
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "utils/meshoptimizer.h"
+#include "utils/vectors.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// CPU-only benchmark for the mesh optimizer: builds a UV sphere as shuffled
+// triangle soup (the worst case for the GPU) and reports what each step buys.
+
+struct Vertex
+{
+    kern::Vector3 pos;
+    kern::Vector3 normal;
+};
+
+static std::vector<Vertex> makeSphereSoup(int rings, int segments)
+{
+    auto point = [&](int r, int s) {
+        float theta = 3.14159265f * r / rings;
+        float phi = 2.0f * 3.14159265f * (s % segments) / segments;
+        kern::Vector3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        return Vertex{ n, n };
+    };
+
+    std::vector<std::array<Vertex, 3>> triangles;
+    for (int r = 0; r < rings; r++)
+    {
+        for (int s = 0; s < segments; s++)
+        {
+            triangles.push_back({ point(r, s), point(r + 1, s), point(r + 1, s + 1) });
+            triangles.push_back({ point(r, s), point(r + 1, s + 1), point(r, s + 1) });
+        }
+    }
+
+    // Exporters rarely emit triangles in a cache friendly order
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+
+    std::vector<Vertex> soup;
+    soup.reserve(triangles.size() * 3);
+    for (const auto& tri : triangles)
+    {
+        soup.insert(soup.end(), tri.begin(), tri.end());
+    }
+    return soup;
+}
+
+template<typename F>
+static double timeMs(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    std::vector<Vertex> soup = makeSphereSoup(256, 512);
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    std::printf("input: %zu vertices, %zu triangles (%zu KB)\n",
+        soup.size(), soup.size() / 3, soup.size() * sizeof(Vertex) / 1024);
+
+    // 1. Weld
+    double weldMs = timeMs([&] { indices = kern::weldVertices(soup, vertices); });
+    auto cacheBefore = kern::analyzeVertexCache(indices, vertices.size());
+    std::printf("weld:  %8.2f ms  %zu -> %zu vertices (%.1fx less vertex memory)\n",
+        weldMs, soup.size(), vertices.size(), double(soup.size()) / vertices.size());
+    std::printf("       ACMR %.3f (soup: 3.000)  ATVR %.3f\n", cacheBefore.acmr, cacheBefore.atvr);
+
+    // 2. Vertex cache order
+    double cacheMs = timeMs([&] { kern::optimizeVertexCache(indices, vertices.size()); });
+    auto cacheAfter = kern::analyzeVertexCache(indices, vertices.size());
+    std::printf("cache: %8.2f ms  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f\n",
+        cacheMs, cacheBefore.acmr, cacheAfter.acmr, cacheBefore.atvr, cacheAfter.atvr);
+
+    // 3. Vertex fetch order
+    auto fetchBefore = kern::analyzeVertexFetch(indices, vertices.size(), sizeof(Vertex));
+    double fetchMs = timeMs([&] { kern::optimizeVertexFetch(vertices, indices); });
+    auto fetchAfter = kern::analyzeVertexFetch(indices, vertices.size(), sizeof(Vertex));
+    std::printf("fetch: %8.2f ms  overfetch %.3f -> %.3f\n", fetchMs, fetchBefore.overfetch, fetchAfter.overfetch);
+
+    std::printf("index type: %s\n", vertices.size() <= kern::maxShortIndexVertices ? "u16" : "u32");
+
+    return 0;
+}
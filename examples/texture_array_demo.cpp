@@ -0,0 +1,97 @@
+#include "kern.h"
+#include <cstdint>
+#include <vector>
+
+struct Vertex
+{
+    kern::Vector2 pos;
+    kern::Vector2 uv;
+};
+
+struct Instance
+{
+    kern::Vector2 offset;
+    float layer;
+};
+
+int main()
+{
+    kern::Window window =
+        kern::initWindow(800, 800, "Kern - Texture Arrays");
+
+    auto shader = kern::createShader(
+        "examples/texturearray.vert",
+        "examples/texturearray.frag"
+    );
+
+    shader.setVertexLayout(
+        kern::VertexLayout{}
+            .add<kern::Vector2>("a_Position")
+            .add<kern::Vector2>("a_UV")
+            .addInstanced<kern::Vector2>("i_Offset")
+            .addInstanced<float>("i_Layer")
+    );
+
+    // Eight same-sized "materials" in one texture, a checkerboard each
+    const uint32_t size = 64, layers = 8;
+    kern::OpenGLTexture2DArray materials(size, size, layers);
+    std::vector<uint8_t> pixels(size * size * 4);
+    for (uint32_t layer = 0; layer < layers; layer++)
+    {
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const bool dark = ((x / 8) + (y / 8)) % 2 == 0;
+                uint8_t* p = &pixels[(y * size + x) * 4];
+                p[0] = static_cast<uint8_t>(dark ? 40 : 255 * ((layer >> 0) & 1));
+                p[1] = static_cast<uint8_t>(dark ? 40 : 255 * ((layer >> 1) & 1));
+                p[2] = static_cast<uint8_t>(dark ? 40 : 255 * ((layer >> 2) & 1));
+                p[3] = 255;
+            }
+        }
+        materials.setLayer(layer, pixels.data(), size, size);
+    }
+    materials.generateMipmaps();
+
+    // A second sampler in the same program gets its own texture unit
+    auto overlay = kern::loadTexture("assets/kern-logo.png");
+
+    const float s = 0.009f;
+    std::vector<Vertex> quadVertices = {
+        {{-s,-s},{0,0}}, {{ s,-s},{1,0}}, {{ s, s},{1,1}},
+        {{ s, s},{1,1}}, {{-s, s},{0,1}}, {{-s,-s},{0,0}},
+    };
+    kern::Mesh quad = kern::createMesh(quadVertices, shader.getVertexLayout());
+
+    // 10k quads, each picking its own layer, in a single draw call
+    const int side = 100;
+    std::vector<Instance> instances;
+    for (int y = 0; y < side; y++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            instances.push_back({
+                { -0.99f + x * 0.02f, -0.99f + y * 0.02f },
+                static_cast<float>((x * 7 + y * 3) % layers)
+            });
+        }
+    }
+
+    kern::UniformHandle texturesUniform = shader.uniform("u_Textures");
+    kern::UniformHandle overlayUniform = shader.uniform("u_Overlay");
+
+    while (window.isOpen())
+    {
+        window.clear();
+        window.clearColor(0.1f, 0.1f, 0.1f);
+
+        shader.setTexture(texturesUniform, materials);
+        shader.setTexture(overlayUniform, overlay);
+        window.drawInstanced(quad, instances, shader);
+
+        window.present();
+    }
+
+    return 0;
+}
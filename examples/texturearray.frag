@@ -0,0 +1,15 @@
+#version 330 core
+uniform sampler2DArray u_Textures;
+uniform sampler2D u_Overlay;
+
+in vec2 v_UV;
+flat in float v_Layer;
+
+out vec4 fragColor;
+
+void main()
+{
+    vec4 base = texture(u_Textures, vec3(v_UV, v_Layer));
+    vec4 overlay = texture(u_Overlay, v_UV);
+    fragColor = vec4(mix(base.rgb, overlay.rgb, overlay.a * 0.25), 1.0);
+}
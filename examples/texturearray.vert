@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec2 a_Position;
+layout (location = 1) in vec2 a_UV;
+layout (location = 2) in vec2 i_Offset;
+layout (location = 3) in float i_Layer;
+
+out vec2 v_UV;
+flat out float v_Layer;
+
+void main()
+{
+    gl_Position = vec4(a_Position + i_Offset, 0.0, 1.0);
+    v_UV = a_UV;
+    v_Layer = i_Layer;
+}
@@ -0,0 +1,191 @@
+#include "opengldebug.h"
+#include "openglextensions.h"
+#include "config.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct DebugMessage
+{
+    std::string text;
+    kern::DebugLevel level;
+};
+
+// Async callbacks may arrive on a driver thread, so messages are queued and
+// logged from the render thread in flushOpenGLDebugMessages()
+std::mutex messageMutex;
+std::vector<DebugMessage> pendingMessages;
+size_t droppedMessages = 0;
+
+// A broken frame can report the same error thousands of times
+constexpr size_t maxPendingMessages = 256;
+
+const char* sourceName(GLenum source)
+{
+    switch (source)
+    {
+        case GL_DEBUG_SOURCE_API:             return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "Window System";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader Compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY:     return "Third Party";
+        case GL_DEBUG_SOURCE_APPLICATION:     return "Application";
+        default:                              return "Other";
+    }
+}
+
+const char* typeName(GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR:               return "Error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "Undefined Behavior";
+        case GL_DEBUG_TYPE_PORTABILITY:         return "Portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:         return "Performance";
+        default:                                return "Other";
+    }
+}
+
+kern::DebugLevel severityLevel(GLenum type, GLenum severity)
+{
+    if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH)
+    {
+        return kern::DebugLevel::Error;
+    }
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+    {
+        return kern::DebugLevel::Everything;
+    }
+    return kern::DebugLevel::Warning;
+}
+
+void APIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                            GLsizei length, const GLchar* message, const void* userParam)
+{
+    (void)userParam;
+
+    std::string text = std::string("OpenGL ") + typeName(type) + " (" + sourceName(source) + ", " +
+                       std::to_string(id) + "): " + std::string(message, length > 0 ? size_t(length) : std::char_traits<char>::length(message));
+    const kern::DebugLevel level = severityLevel(type, severity);
+
+#if KERN_GL_VALIDATION >= 2
+    // Synchronous output runs on the thread that made the call, log it right
+    // away so a breakpoint here lands on the offending call
+    cast(text, level);
+#else
+    std::lock_guard<std::mutex> lock(messageMutex);
+    if (pendingMessages.size() >= maxPendingMessages)
+    {
+        droppedMessages++;
+        return;
+    }
+    pendingMessages.push_back({ std::move(text), level });
+#endif
+}
+
+const char* errorName(GLenum error)
+{
+    switch (error)
+    {
+        case GL_INVALID_ENUM:                  return "GL_INVALID_ENUM";
+        case GL_INVALID_VALUE:                 return "GL_INVALID_VALUE";
+        case GL_INVALID_OPERATION:             return "GL_INVALID_OPERATION";
+        case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+        case GL_OUT_OF_MEMORY:                 return "GL_OUT_OF_MEMORY";
+        default:                               return "unknown error";
+    }
+}
+
+} // namespace
+
+bool kern::enableOpenGLDebugOutput(GLADloadproc load)
+{
+#if KERN_GL_VALIDATION == 0
+    (void)load;
+    return false;
+#else
+    PFNKERNDEBUGMESSAGECALLBACKPROC debugMessageCallback = nullptr;
+    PFNKERNDEBUGMESSAGECONTROLPROC debugMessageControl = nullptr;
+    const char* flavor = nullptr;
+    bool khrDebug = false;
+
+    if (isOpenGLVersionAtLeast(4, 3) || hasOpenGLExtension("GL_KHR_debug"))
+    {
+        debugMessageCallback = reinterpret_cast<PFNKERNDEBUGMESSAGECALLBACKPROC>(load("glDebugMessageCallback"));
+        debugMessageControl = reinterpret_cast<PFNKERNDEBUGMESSAGECONTROLPROC>(load("glDebugMessageControl"));
+        flavor = "KHR_debug";
+        khrDebug = true;
+    }
+    else if (hasOpenGLExtension("GL_ARB_debug_output"))
+    {
+        debugMessageCallback = reinterpret_cast<PFNKERNDEBUGMESSAGECALLBACKPROC>(load("glDebugMessageCallbackARB"));
+        debugMessageControl = reinterpret_cast<PFNKERNDEBUGMESSAGECONTROLPROC>(load("glDebugMessageControlARB"));
+        flavor = "ARB_debug_output";
+    }
+
+    if (!debugMessageCallback)
+    {
+        cast("GL debug output unavailable, validation disabled", DebugLevel::Warning);
+        return false;
+    }
+
+    // GL_DEBUG_OUTPUT only exists with KHR_debug; ARB_debug_output is
+    // always on in a debug context
+    if (khrDebug)
+    {
+        glEnable(GL_DEBUG_OUTPUT);
+    }
+
+#if KERN_GL_VALIDATION >= 2
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#else
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+
+    debugMessageCallback(debugCallback, nullptr);
+
+    if (debugMessageControl && debug != DebugLevel::Everything)
+    {
+        // Notifications (buffer placement hints etc.) only at the chattiest level
+        debugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    }
+
+    cast(std::string("GL debug output: ") + flavor + ", validation level " + std::to_string(KERN_GL_VALIDATION));
+    return true;
+#endif
+}
+
+void kern::flushOpenGLDebugMessages()
+{
+#if KERN_GL_VALIDATION == 1
+    std::vector<DebugMessage> messages;
+    size_t dropped;
+    {
+        std::lock_guard<std::mutex> lock(messageMutex);
+        messages.swap(pendingMessages);
+        dropped = droppedMessages;
+        droppedMessages = 0;
+    }
+
+    for (const DebugMessage& message : messages)
+    {
+        cast(message.text, message.level);
+    }
+
+    if (dropped > 0)
+    {
+        cast("OpenGL debug output: " + std::to_string(dropped) + " more messages dropped this frame", DebugLevel::Warning);
+    }
+#endif
+}
+
+void kern::checkOpenGLError(const char* call, const char* file, int line)
+{
+    for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError())
+    {
+        cast(std::string("OpenGL ") + errorName(error) + " @ " + call + " (" + file + ":" + std::to_string(line) + ")", DebugLevel::Error);
+    }
+}
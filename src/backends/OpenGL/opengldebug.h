@@ -0,0 +1,75 @@
+// src/backends/OpenGL/opengldebug.h
+#pragma once
+
+#include <glad/glad.h>
+
+// GL validation level, fixed at compile time (set from CMake):
+//   0 - nothing on the draw path; the release default
+//   1 - KHR_debug / ARB_debug_output callback, messages logged once per frame
+//   2 - synchronous callback logged at the offending call, plus glGetError
+//       after every GL_CHECK; the slowest and most precise
+#ifndef KERN_GL_VALIDATION
+    #ifdef NDEBUG
+        #define KERN_GL_VALIDATION 0
+    #else
+        #define KERN_GL_VALIDATION 1
+    #endif
+#endif
+
+#if KERN_GL_VALIDATION >= 2
+    #define GL_CHECK(x) do { x; kern::checkOpenGLError(#x, __FILE__, __LINE__); } while (0)
+#else
+    #define GL_CHECK(x) x
+#endif
+
+// KHR_debug (core in 4.3)
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_OUTPUT_SYNCHRONOUS
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#endif
+#ifndef GL_DEBUG_SOURCE_API
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#endif
+#ifndef GL_DEBUG_TYPE_ERROR
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#endif
+#ifndef GL_DEBUG_SEVERITY_HIGH
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#endif
+#ifndef GL_DEBUG_SEVERITY_NOTIFICATION
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#endif
+
+namespace kern
+{
+    typedef void (APIENTRY *PFNKERNDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                              GLsizei length, const GLchar* message, const void* userParam);
+    typedef void (APIENTRYP PFNKERNDEBUGMESSAGECALLBACKPROC)(PFNKERNDEBUGPROC callback, const void* userParam);
+    typedef void (APIENTRYP PFNKERNDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity,
+                                                            GLsizei count, const GLuint* ids, GLboolean enabled);
+
+    // Installs the debug callback when KERN_GL_VALIDATION > 0 and the context
+    // offers KHR_debug or ARB_debug_output. Returns false if nothing was installed.
+    bool enableOpenGLDebugOutput(GLADloadproc load);
+
+    // Logs the messages the driver reported since the last call; the renderer
+    // calls this once per frame
+    void flushOpenGLDebugMessages();
+
+    // Drains glGetError; only used by GL_CHECK at validation level 2
+    void checkOpenGLError(const char* call, const char* file, int line);
+}
@@ -0,0 +1,78 @@
+#include "openglextensions.h"
+#include "config.h"
+
+#include <cstring>
+
+bool kern::hasOpenGLExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; i++)
+    {
+        const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (ext && std::strcmp(ext, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool kern::isOpenGLVersionAtLeast(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+void kern::loadOpenGLExtensions(GLADloadproc load)
+{
+    glExtensions = OpenGLExtensions{};
+
+    if (isOpenGLVersionAtLeast(4, 4) || hasOpenGLExtension("GL_ARB_buffer_storage"))
+    {
+        glExtensions.glBufferStorage = reinterpret_cast<PFNKERNBUFFERSTORAGEPROC>(load("glBufferStorage"));
+        glExtensions.bufferStorage = glExtensions.glBufferStorage != nullptr;
+    }
+
+    glExtensions.textureCompressionS3TC = hasOpenGLExtension("GL_EXT_texture_compression_s3tc");
+    glExtensions.textureCompressionSRGB = glExtensions.textureCompressionS3TC &&
+        (hasOpenGLExtension("GL_EXT_texture_sRGB") || hasOpenGLExtension("GL_EXT_texture_compression_s3tc_srgb"));
+    glExtensions.textureCompressionBPTC = isOpenGLVersionAtLeast(4, 2) || hasOpenGLExtension("GL_ARB_texture_compression_bptc");
+    glExtensions.rgb565 = isOpenGLVersionAtLeast(4, 1) || hasOpenGLExtension("GL_ARB_ES2_compatibility");
+
+    if (isOpenGLVersionAtLeast(4, 1) || hasOpenGLExtension("GL_ARB_get_program_binary"))
+    {
+        glExtensions.glGetProgramBinary = reinterpret_cast<PFNKERNGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+        glExtensions.glProgramBinary = reinterpret_cast<PFNKERNPROGRAMBINARYPROC>(load("glProgramBinary"));
+        glExtensions.glProgramParameteri = reinterpret_cast<PFNKERNPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+
+        // Some drivers expose the entry points but no format to save in
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        glExtensions.programBinary = formats > 0 && glExtensions.glGetProgramBinary &&
+            glExtensions.glProgramBinary && glExtensions.glProgramParameteri;
+    }
+
+    // Same enums either way; the KHR and ARB entry points only differ in suffix
+    if (hasOpenGLExtension("GL_KHR_parallel_shader_compile"))
+    {
+        glExtensions.glMaxShaderCompilerThreads = reinterpret_cast<PFNKERNMAXSHADERCOMPILERTHREADSPROC>(load("glMaxShaderCompilerThreadsKHR"));
+        glExtensions.parallelShaderCompile = true;
+    }
+    else if (hasOpenGLExtension("GL_ARB_parallel_shader_compile"))
+    {
+        glExtensions.glMaxShaderCompilerThreads = reinterpret_cast<PFNKERNMAXSHADERCOMPILERTHREADSPROC>(load("glMaxShaderCompilerThreadsARB"));
+        glExtensions.parallelShaderCompile = true;
+    }
+    if (glExtensions.glMaxShaderCompilerThreads)
+    {
+        // 0xFFFFFFFF lets the driver use as many threads as it sees fit
+        glExtensions.glMaxShaderCompilerThreads(0xFFFFFFFFu);
+    }
+
+    cast(std::string("ARB_buffer_storage: ") + (glExtensions.bufferStorage ? "yes" : "no"));
+    cast(std::string("Texture compression: S3TC ") + (glExtensions.textureCompressionS3TC ? "yes" : "no") +
+         ", BPTC " + (glExtensions.textureCompressionBPTC ? "yes" : "no"));
+    cast(std::string("Program binaries: ") + (glExtensions.programBinary ? "yes" : "no") +
+         ", parallel compile: " + (glExtensions.parallelShaderCompile ? "yes" : "no"));
+}
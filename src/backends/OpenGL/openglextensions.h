@@ -0,0 +1,113 @@
+// src/backends/OpenGL/openglextensions.h
+#pragma once
+
+#include <glad/glad.h>
+
+// The bundled glad loader only carries GL 3.3 core, so the few extensions
+// Kern can take advantage of are resolved here at runtime.
+
+// ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_CLIENT_STORAGE_BIT
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+// EXT_texture_compression_s3tc, EXT_texture_sRGB
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// ARB_texture_compression_bptc
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+// ARB_ES2_compatibility
+#ifndef GL_RGB565
+#define GL_RGB565 0x8D62
+#endif
+
+// ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_PROGRAM_BINARY_FORMATS
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+// KHR_parallel_shader_compile, ARB_parallel_shader_compile
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace kern
+{
+    typedef void (APIENTRYP PFNKERNBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+    typedef void (APIENTRYP PFNKERNGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRYP PFNKERNPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void (APIENTRYP PFNKERNPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+    typedef void (APIENTRYP PFNKERNMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+    struct OpenGLExtensions
+    {
+        bool bufferStorage = false;
+        PFNKERNBUFFERSTORAGEPROC glBufferStorage = nullptr;
+
+        bool textureCompressionS3TC = false;   // BC1, BC3
+        bool textureCompressionSRGB = false;   // sRGB BC1, BC3
+        bool textureCompressionBPTC = false;   // BC7; RGTC (BC4, BC5) is core
+        bool rgb565 = false;                   // Otherwise GL_RGB565 falls back to GL_RGB5
+
+        // Only set when the driver also offers at least one binary format
+        bool programBinary = false;
+        PFNKERNGETPROGRAMBINARYPROC glGetProgramBinary = nullptr;
+        PFNKERNPROGRAMBINARYPROC glProgramBinary = nullptr;
+        PFNKERNPROGRAMPARAMETERIPROC glProgramParameteri = nullptr;
+
+        // GL_COMPLETION_STATUS_KHR can be polled without blocking
+        bool parallelShaderCompile = false;
+        PFNKERNMAXSHADERCOMPILERTHREADSPROC glMaxShaderCompilerThreads = nullptr;
+    };
+
+    inline OpenGLExtensions glExtensions;
+
+    // Needs a current context; call right after the core loader succeeded
+    void loadOpenGLExtensions(GLADloadproc load);
+    bool hasOpenGLExtension(const char* name);
+    bool isOpenGLVersionAtLeast(int major, int minor);
+}
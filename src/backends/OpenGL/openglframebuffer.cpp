@@ -0,0 +1,111 @@
+#include "openglframebuffer.h"
+#include "config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+kern::OpenGLFramebuffer::OpenGLFramebuffer(int width, int height)
+{
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &color);
+    glGenRenderbuffers(1, &depth);
+    resize(width, height);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        cast("Offscreen framebuffer incomplete, status " + std::to_string(status), DebugLevel::Error);
+        release();
+    }
+}
+
+kern::OpenGLFramebuffer::~OpenGLFramebuffer()
+{
+    release();
+}
+
+kern::OpenGLFramebuffer::OpenGLFramebuffer(OpenGLFramebuffer&& other) noexcept
+    : framebuffer(other.framebuffer), color(other.color), depth(other.depth),
+      width(other.width), height(other.height)
+{
+    other.framebuffer = other.color = other.depth = 0;
+}
+
+kern::OpenGLFramebuffer& kern::OpenGLFramebuffer::operator=(OpenGLFramebuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        framebuffer = other.framebuffer;
+        color = other.color;
+        depth = other.depth;
+        width = other.width;
+        height = other.height;
+        other.framebuffer = other.color = other.depth = 0;
+    }
+    return *this;
+}
+
+void kern::OpenGLFramebuffer::release()
+{
+    if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
+    if (color) glDeleteRenderbuffers(1, &color);
+    if (depth) glDeleteRenderbuffers(1, &depth);
+    framebuffer = color = depth = 0;
+}
+
+void kern::OpenGLFramebuffer::resize(int w, int h)
+{
+    if (!color || !depth) return;
+
+    // Renderbuffers keep their names, so the attachments stay valid
+    width = std::max(w, 1);
+    height = std::max(h, 1);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+void kern::OpenGLFramebuffer::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+std::vector<uint8_t> kern::OpenGLFramebuffer::readPixels() const
+{
+    if (!framebuffer) return {};
+
+    const size_t rowSize = size_t(width) * 4;
+    std::vector<uint8_t> pixels(rowSize * height);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+    // GL returns the bottom row first
+    std::vector<uint8_t> row(rowSize);
+    for (int y = 0; y < height / 2; y++)
+    {
+        uint8_t* top = pixels.data() + size_t(y) * rowSize;
+        uint8_t* bottom = pixels.data() + size_t(height - 1 - y) * rowSize;
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+    return pixels;
+}
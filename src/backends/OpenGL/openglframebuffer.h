@@ -0,0 +1,48 @@
+// src/backends/OpenGL/openglframebuffer.h
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+namespace kern
+{
+    // Offscreen render target: an RGBA8 color and a depth-stencil
+    // renderbuffer, so rendering needs no default framebuffer at all
+    class OpenGLFramebuffer
+    {
+    public:
+        OpenGLFramebuffer() = default;
+        OpenGLFramebuffer(int width, int height);
+        ~OpenGLFramebuffer();
+
+        OpenGLFramebuffer(const OpenGLFramebuffer&) = delete;
+        OpenGLFramebuffer& operator=(const OpenGLFramebuffer&) = delete;
+        OpenGLFramebuffer(OpenGLFramebuffer&& other) noexcept;
+        OpenGLFramebuffer& operator=(OpenGLFramebuffer&& other) noexcept;
+
+        // Reallocates the attachments; their contents are lost
+        void resize(int width, int height);
+
+        // Draws and reads go here until another framebuffer is bound
+        void bind() const;
+
+        // Color attachment as tightly packed RGBA8, top row first like an
+        // image file. Waits for the GPU to finish the frame.
+        std::vector<uint8_t> readPixels() const;
+
+        bool isValid() const { return framebuffer != 0; }
+        GLuint getId() const { return framebuffer; }
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+
+    private:
+        GLuint framebuffer = 0;
+        GLuint color = 0;
+        GLuint depth = 0;
+        int width = 0;
+        int height = 0;
+
+        void release();
+    };
+}
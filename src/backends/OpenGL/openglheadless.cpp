@@ -0,0 +1,158 @@
+#include "openglheadless.h"
+#include "config.h"
+
+#if KERN_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+namespace
+{
+    // Extension strings are space separated; match whole names only
+    bool hasExtension(const char* extensions, const char* name)
+    {
+        if (!extensions) return false;
+
+        const size_t length = std::strlen(name);
+        for (const char* at = std::strstr(extensions, name); at; at = std::strstr(at + length, name))
+        {
+            const bool starts = at == extensions || at[-1] == ' ';
+            const bool ends = at[length] == ' ' || at[length] == '\0';
+            if (starts && ends) return true;
+        }
+        return false;
+    }
+}
+
+kern::OpenGLHeadlessContext::~OpenGLHeadlessContext()
+{
+    destroy();
+}
+
+bool kern::OpenGLHeadlessContext::create(int major, int minor, bool debug)
+{
+    destroy();
+
+    // Client extensions, queried without a display
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (!getPlatformDisplay || !hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        cast("Headless: EGL has no surfaceless platform", DebugLevel::Warning);
+        return false;
+    }
+
+    EGLDisplay eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+    {
+        cast("Headless: failed to initialize the surfaceless EGL display", DebugLevel::Warning);
+        return false;
+    }
+    display = eglDisplay;
+
+    const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+    if (!hasExtension(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API))
+    {
+        cast("Headless: EGL can't make a desktop OpenGL context current without a surface", DebugLevel::Warning);
+        destroy();
+        return false;
+    }
+
+    // No surface is ever created, so any OpenGL capable config will do, or
+    // none at all where the driver allows it
+    const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0)
+    {
+        config = EGL_NO_CONFIG_KHR;
+        if (!hasExtension(extensions, "EGL_KHR_no_config_context"))
+        {
+            cast("Headless: no EGL config for desktop OpenGL", DebugLevel::Warning);
+            destroy();
+            return false;
+        }
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_DEBUG, debug ? EGL_TRUE : EGL_FALSE,
+        EGL_NONE
+    };
+    context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT)
+    {
+        context = nullptr;
+        cast("Headless: failed to create an OpenGL " + std::to_string(major) + "." + std::to_string(minor) + " core context", DebugLevel::Warning);
+        destroy();
+        return false;
+    }
+
+    const char* vendor = eglQueryString(eglDisplay, EGL_VENDOR);
+    cast("Headless: surfaceless EGL context created (" + std::string(vendor ? vendor : "unknown vendor") + ")");
+    return true;
+}
+
+bool kern::OpenGLHeadlessContext::makeCurrent(bool current)
+{
+    if (!display) return false;
+
+    if (!current)
+    {
+        return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE;
+    }
+    return context && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE;
+}
+
+void* kern::OpenGLHeadlessContext::getProcAddress(const char* name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+void kern::OpenGLHeadlessContext::destroy()
+{
+    if (!display) return;
+
+    if (context)
+    {
+        if (eglGetCurrentContext() == context)
+        {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        }
+        eglDestroyContext(display, context);
+        context = nullptr;
+    }
+
+    // Every context in the process shares the display, so it stays initialized
+    display = nullptr;
+}
+
+#else
+
+// Built without EGL: headless windows fall back to GLFW's OSMesa context
+
+kern::OpenGLHeadlessContext::~OpenGLHeadlessContext() = default;
+
+bool kern::OpenGLHeadlessContext::create(int, int, bool)
+{
+    cast("Headless: built without EGL", DebugLevel::Warning);
+    return false;
+}
+
+bool kern::OpenGLHeadlessContext::makeCurrent(bool)
+{
+    return false;
+}
+
+void* kern::OpenGLHeadlessContext::getProcAddress(const char*)
+{
+    return nullptr;
+}
+
+void kern::OpenGLHeadlessContext::destroy()
+{
+}
+
+#endif
@@ -0,0 +1,37 @@
+// src/backends/OpenGL/openglheadless.h
+#pragma once
+
+namespace kern
+{
+    // An OpenGL context with no window and no display server: EGL on Mesa's
+    // surfaceless platform, current without any surface (EGL_KHR_surfaceless_context).
+    // Rendering needs a framebuffer object, there is no default framebuffer.
+    // Only available where the library was built against EGL.
+    class OpenGLHeadlessContext
+    {
+    public:
+        OpenGLHeadlessContext() = default;
+        ~OpenGLHeadlessContext();
+
+        OpenGLHeadlessContext(const OpenGLHeadlessContext&) = delete;
+        OpenGLHeadlessContext& operator=(const OpenGLHeadlessContext&) = delete;
+
+        // Core profile of at least major.minor; false if EGL or any of the
+        // extensions it needs is missing
+        bool create(int major, int minor, bool debug);
+
+        // On the calling thread; false releases it
+        bool makeCurrent(bool current);
+
+        bool isValid() const { return context != nullptr; }
+
+        // GL entry points for glad, valid once a context was created
+        static void* getProcAddress(const char* name);
+
+    private:
+        void* display = nullptr;
+        void* context = nullptr;
+
+        void destroy();
+    };
+}
@@ -0,0 +1,200 @@
+#include "openglprogramcache.h"
+#include "openglextensions.h"
+#include "config.h"
+#include "utils/files.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
+namespace
+{
+    constexpr uint32_t fileMagic = 0x3142504B;  // "KPB1"
+
+    // Stored ahead of the binary; the check hash guards against a name
+    // collision handing back another program
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t format;
+        uint64_t check;
+    };
+
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string glString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+
+    // Empty if the platform won't tell, the working directory is used then
+    std::filesystem::path executableDirectory()
+    {
+        std::filesystem::path executable;
+#if defined(_WIN32)
+        wchar_t buffer[MAX_PATH];
+        const DWORD length = GetModuleFileNameW(nullptr, buffer, MAX_PATH);
+        if (length > 0 && length < MAX_PATH) executable = std::filesystem::path(buffer, buffer + length);
+#elif defined(__APPLE__)
+        char buffer[4096];
+        uint32_t size = sizeof(buffer);
+        if (_NSGetExecutablePath(buffer, &size) == 0) executable = buffer;
+#else
+        std::error_code error;
+        executable = std::filesystem::read_symlink("/proc/self/exe", error);
+#endif
+        return executable.parent_path();
+    }
+}
+
+std::string kern::OpenGLProgramCache::getResolvedDirectory() const
+{
+    if (directory.empty()) return {};
+
+    // Looked up once, the executable doesn't move while it runs
+    static const std::filesystem::path executable = executableDirectory();
+    const std::filesystem::path base = baseDirectory ? std::filesystem::path(*baseDirectory) : executable;
+
+    // An absolute directory replaces the base
+    return (base / directory).string();
+}
+
+bool kern::OpenGLProgramCache::isEnabled() const
+{
+    return glExtensions.programBinary && !directory.empty();
+}
+
+uint64_t kern::OpenGLProgramCache::hashSources(const std::string& vertexSource, const std::string& fragmentSource, uint64_t seed)
+{
+    if (driver.empty())
+    {
+        driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION) + "|" + glString(GL_SHADING_LANGUAGE_VERSION);
+
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+        binaryFormats.resize(static_cast<size_t>(std::max(count, 0)));
+        if (count > 0) glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, binaryFormats.data());
+    }
+
+    // Lengths go in too, so moving text from one stage to the other changes the key
+    const uint64_t lengths[2] = { vertexSource.size(), fragmentSource.size() };
+    uint64_t hash = fnv1a(driver.data(), driver.size(), seed);
+    hash = fnv1a(lengths, sizeof(lengths), hash);
+    hash = fnv1a(vertexSource.data(), vertexSource.size(), hash);
+    return fnv1a(fragmentSource.data(), fragmentSource.size(), hash);
+}
+
+std::string kern::OpenGLProgramCache::pathFor(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(getResolvedDirectory()) / name).string();
+}
+
+GLuint kern::OpenGLProgramCache::load(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    if (!isEnabled() || vertexSource.empty() || fragmentSource.empty()) return 0;
+
+    const uint64_t key = hashSources(vertexSource, fragmentSource, 14695981039346656037ull);
+    const std::string path = pathFor(key);
+    const std::vector<uint8_t> file = readBinaryFile(path);
+    if (file.size() <= sizeof(FileHeader))
+    {
+        stats.misses++;
+        return 0;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    const bool knownFormat = std::find(binaryFormats.begin(), binaryFormats.end(), static_cast<GLint>(header.format)) != binaryFormats.end();
+
+    if (header.magic != fileMagic || header.check != hashSources(vertexSource, fragmentSource, key) || !knownFormat)
+    {
+        stats.misses++;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glExtensions.glProgramBinary(program, header.format, file.data() + sizeof(header), static_cast<GLsizei>(file.size() - sizeof(header)));
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        // Typically a driver change that kept the version string; rebuild it
+        cast("Program cache: binary rejected, recompiling '" + path + "'", DebugLevel::Warning);
+        glDeleteProgram(program);
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        stats.rejected++;
+        return 0;
+    }
+
+    stats.hits++;
+    return program;
+}
+
+void kern::OpenGLProgramCache::store(GLuint program, const std::string& vertexSource, const std::string& fragmentSource)
+{
+    if (!isEnabled() || !program) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    const uint64_t key = hashSources(vertexSource, fragmentSource, 14695981039346656037ull);
+
+    std::vector<uint8_t> file(sizeof(FileHeader) + static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    glExtensions.glGetProgramBinary(program, length, &written, &format, file.data() + sizeof(FileHeader));
+    if (written <= 0) return;
+    file.resize(sizeof(FileHeader) + static_cast<size_t>(written));
+
+    const FileHeader header = { fileMagic, format, hashSources(vertexSource, fragmentSource, key) };
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    std::error_code error;
+    const std::string resolved = getResolvedDirectory();
+    std::filesystem::create_directories(resolved, error);
+    if (error)
+    {
+        cast("Program cache: can't create '" + resolved + "', caching disabled", DebugLevel::Warning);
+        directory.clear();
+        return;
+    }
+
+    // Written aside and renamed, so another instance never reads half a file
+    const std::string path = pathFor(key);
+    const std::string temporary = path + ".tmp";
+    bool saved;
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        saved = static_cast<bool>(out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size())));
+    }
+    if (saved) std::filesystem::rename(temporary, path, error);
+    if (!saved || error)
+    {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    stats.stored++;
+}
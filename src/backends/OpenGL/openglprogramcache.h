@@ -0,0 +1,64 @@
+// src/backends/OpenGL/openglprogramcache.h
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace kern
+{
+    struct ProgramCacheStats
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t rejected = 0;  // Found on disk, but the driver refused it
+        size_t stored = 0;
+    };
+
+    // Linked program binaries on disk (ARB_get_program_binary), one file per
+    // program named after a hash of both sources and the driver's vendor,
+    // renderer and version strings. A driver update changes the name, so
+    // stale binaries are simply never looked up again; a binary the driver
+    // still rejects is deleted and the program is compiled from source.
+    class OpenGLProgramCache
+    {
+    public:
+        // Absolute, or relative to the base directory; empty turns the cache off
+        void setDirectory(const std::string& path) { directory = path; }
+        const std::string& getDirectory() const { return directory; }
+
+        // Where a relative directory is resolved: the executable's directory
+        // unless set, so the cache doesn't move with the working directory.
+        // Setting it to "" resolves against the working directory instead.
+        void setBaseDirectory(const std::string& path) { baseDirectory = path; }
+
+        // The directory the binaries are actually read from and written to
+        std::string getResolvedDirectory() const;
+
+        // Needs a current context with program binary support
+        bool isEnabled() const;
+
+        // A linked program built from the cached binary, 0 on a miss
+        GLuint load(const std::string& vertexSource, const std::string& fragmentSource);
+
+        // Saves a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+        void store(GLuint program, const std::string& vertexSource, const std::string& fragmentSource);
+
+        const ProgramCacheStats& getStats() const { return stats; }
+
+    private:
+        std::string directory = ".kern_cache";
+        std::optional<std::string> baseDirectory;  // Executable's directory when unset
+        std::string driver;                // Vendor, renderer and version; read on first use
+        std::vector<GLint> binaryFormats;  // What this driver accepts
+        ProgramCacheStats stats;
+
+        uint64_t hashSources(const std::string& vertexSource, const std::string& fragmentSource, uint64_t seed);
+        std::string pathFor(uint64_t key) const;
+    };
+
+    inline OpenGLProgramCache programCache;
+}
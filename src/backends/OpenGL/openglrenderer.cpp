@@ -2,51 +2,96 @@
 #include "utils/vectors.h"
 #include "utils/colors.h"
 #include "utils/shaders.h"
-#include "utils/files.h"
 #include "utils/vertexlayout.h"
+#include "utils/meshoptimizer.h"
+#include "backends/OpenGL/opengldebug.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <numeric>
 #include <unordered_map>
 
-#define GL_CHECK(x) do { \
-    x; \
-    GLenum glErr = glGetError(); \
-    if (glErr != GL_NO_ERROR) { \
-        std::cerr << "[KERN] OpenGL Error @ " << #x << ": " << glErr << std::endl; \
-    } \
-} while(0)
+namespace {
 
+// Built-in sources are embedded in the library, so this reads no files
+kern::OpenGLShaderProgram loadBuiltinProgram(const kern::ShaderLibrary& library, const std::string& name)
+{
+    cast("Loading built-in shader '" + name + "'...");
+    const std::string vertexName = name + ".vert";
+    const std::string fragmentName = name + ".frag";
+
+    std::string vertexSource = library.preprocess(vertexName);
+    std::string fragmentSource = library.preprocess(fragmentName);
+
+    if (vertexSource.empty()) {
+        cast("Vertex shader source empty!", kern::DebugLevel::Error);
+        return kern::OpenGLShaderProgram("", ""); // Invalid
+    }
+    if (fragmentSource.empty()) {
+        cast("Fragment shader source empty!", kern::DebugLevel::Error);
+        return kern::OpenGLShaderProgram("", "");
+    }
+
+    return kern::OpenGLShaderProgram(vertexSource, fragmentSource, vertexName, fragmentName);
+}
+
+} // namespace
 
 OpenGLRenderer::OpenGLRenderer(GLFWwindow* window, int width, int height)
     : window(window), width(width), height(height),
-      triProgram(
-          []() -> kern::OpenGLShaderProgram
-          {
-              cast("Loading built-in shaders...");
-              std::string triVertexSource = kern::readFile("src/shaders/OpenGL/tri.vert");
-              std::string triFragmentSource = kern::readFile("src/shaders/OpenGL/tri.frag");
-
-              if (triVertexSource.empty()) {
-                  cast("Vertex shader source empty!", kern::DebugLevel::Error);
-                  return kern::OpenGLShaderProgram("", ""); // Invalid
-              }
-              if (triFragmentSource.empty()) {
-                  cast("Fragment shader source empty!", kern::DebugLevel::Error);
-                  return kern::OpenGLShaderProgram("", "");
-              }
-
-              return kern::OpenGLShaderProgram(triVertexSource, triFragmentSource, "shaders/OpenGL/tri.vert", "shaders/OpenGL/tri.frag");
-          }()
-      )
-{
-    glViewport(0, 0, width, height);
-
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-
-    if (!triProgram.getId()) {
+      triProgram(loadBuiltinProgram(shaderLibrary, "tri")),
+      shapeProgram(loadBuiltinProgram(shaderLibrary, "shape")),
+      spriteProgram(loadBuiltinProgram(shaderLibrary, "sprite"))
+{
+    kern::glState = &state;
+    kern::textureLoader = &textureLoader;
+    kern::shaderLibrary = &shaderLibrary;
+    kern::resourceManager = &resources;
+
+    state.setViewport(0, 0, width, height);
+    state.setDepthTest(true);
+    state.setDepthFunc(GL_LESS);
+
+    frameBlock = kern::UniformBlock<kern::FrameConstants>("KernFrame", kern::frameBlockBinding);
+    frameConstants.viewport[2] = static_cast<float>(width);
+    frameConstants.viewport[3] = static_cast<float>(height);
+    lastPresentTime = glfwGetTime();
+
+    if (!triProgram.getId() || !shapeProgram.getId() || !spriteProgram.getId()) {
         cast("Shader program failed to link!", kern::DebugLevel::Error);
     }
+
+    batchVertices.reserve(maxBatchVertices);
+    shapeInstances.reserve(maxBatchShapes);
+}
+
+OpenGLRenderer::~OpenGLRenderer()
+{
+    if (batchVao.vao) kern::gl::deleteVertexArray(batchVao.vao);
+    if (shapeVao) kern::gl::deleteVertexArray(shapeVao);
+    if (spriteVao) kern::gl::deleteVertexArray(spriteVao);
+
+    for (auto& [hash, entry] : vaoCache) kern::gl::deleteVertexArray(entry.vao);
+
+    if (kern::glState == &state)
+    {
+        kern::glState = nullptr;
+    }
+    if (kern::textureLoader == &textureLoader)
+    {
+        kern::textureLoader = nullptr;
+    }
+    if (kern::resourceManager == &resources)
+    {
+        kern::resourceManager = nullptr;
+    }
+    if (kern::shaderLibrary == &shaderLibrary)
+    {
+        kern::shaderLibrary = nullptr;
+    }
 }
 
 void OpenGLRenderer::clear()
@@ -54,6 +99,8 @@ void OpenGLRenderer::clear()
     if (window)
     {
         updateViewport();
+        // Rebound every frame, other code (atlas blits) borrows the binding
+        if (offscreen.isValid()) offscreen.bind();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
 }
@@ -62,10 +109,235 @@ void OpenGLRenderer::present()
 {
     if (window)
     {
-        glfwSwapBuffers(window);
+        executeQueue();
+        flushBatch();
+        if (!offscreen.isValid()) glfwSwapBuffers(window);
+        streamBuffer.endFrame();
+        // Budgeted, so a burst of loads is spread over several frames
+        textureLoader.update();
+        // Resources released this frame are deleted once its fence signals
+        resources.endFrame();
+        kern::flushOpenGLDebugMessages();
+
+        frameStats.stateChanges = state.getStats().issued;
+        frameStats.redundantStateChanges = state.getStats().skipped;
+        lastFrameStats = frameStats;
+        frameStats = {};
+        state.resetStats();
+
+        const double now = glfwGetTime();
+        frameConstants.time = static_cast<float>(now);
+        frameConstants.deltaTime = static_cast<float>(now - lastPresentTime);
+        lastPresentTime = now;
+        frameDirty = true;
     }
 }
 
+void OpenGLRenderer::setCamera(const kern::Mat4& view, const kern::Mat4& projection)
+{
+    // Draws already queued in the batch were meant for the old camera
+    flushBatch();
+
+    frameConstants.view = view;
+    frameConstants.projection = projection;
+    frameConstants.viewProjection = projection * view;
+    frameDirty = true;
+}
+
+void OpenGLRenderer::executeQueue()
+{
+    if (queue.empty())
+    {
+        return;
+    }
+
+    queue.sort();
+    // Only taken when the queue ran, frameStats starts every frame at zero
+    frameStats.queue = queue.getStats();
+
+    CommandState current;
+    queue.forEach([&](const kern::DrawCommand& command)
+    {
+        executeDrawCommand(command, current);
+    });
+    endDrawCommands(current);
+
+    queue.clear();
+}
+
+void OpenGLRenderer::executeDrawCommand(const kern::DrawCommand& command, CommandState& current)
+{
+    // Pending 2D shapes go out first, under the state they were recorded with
+    flushBatch();
+
+    // Handles are looked up once per program switch, which sorting keeps rare
+    if (command.shader != current.shader)
+    {
+        current.shader = command.shader;
+        current.modelUniform = current.shader->findUniform("u_Model");
+        current.textureUniform = current.shader->findUniform("u_Texture");
+    }
+
+    if (command.transparent != current.blending)
+    {
+        current.blending = command.transparent;
+        state.setBlend(current.blending);
+        state.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        // Transparent surfaces test against depth but don't occlude each other
+        state.setDepthMask(!current.blending);
+    }
+
+    if (current.modelUniform.isValid())
+    {
+        current.shader->setMat4(current.modelUniform, command.model);
+    }
+    if (command.texture && current.textureUniform.isValid())
+    {
+        current.shader->setSample2D(current.textureUniform, *command.texture);
+    }
+
+    draw(*command.mesh, *current.shader);
+}
+
+void OpenGLRenderer::endDrawCommands(CommandState& current)
+{
+    if (current.blending)
+    {
+        state.setBlend(false);
+        state.setDepthMask(true);
+        current.blending = false;
+    }
+}
+
+void OpenGLRenderer::submit(const kern::CommandList& list)
+{
+    const kern::CommandList* lists[] = { &list };
+    submit(lists);
+}
+
+void OpenGLRenderer::submit(std::span<const kern::CommandList* const> lists)
+{
+    CommandState current;
+
+    for (const kern::CommandList* list : lists)
+    {
+        if (!list) continue;
+
+        // Every other command ends a run of DrawCommands first: their blend and
+        // depth mask state must not leak into 2D shapes, sprites or clears
+        for (const kern::CommandList::Command& command : list->getCommands())
+        {
+            switch (command.type)
+            {
+                case kern::CommandList::CommandType::Draw:
+                    executeDrawCommand(command.draw, current);
+                    break;
+                case kern::CommandList::CommandType::Submit:
+                    queue.submit(command.draw);
+                    break;
+                case kern::CommandList::CommandType::DrawMesh:
+                    endDrawCommands(current);
+                    draw(*command.draw.mesh, *command.shader);
+                    break;
+                case kern::CommandList::CommandType::DrawVertices:
+                    endDrawCommands(current);
+                    drawVertices(command.data, command.count, command.stride, *command.shader);
+                    break;
+                case kern::CommandList::CommandType::DrawIndexedVertices:
+                    endDrawCommands(current);
+                    drawIndexedVertices(command.data, command.count, command.stride, command.indices, command.indexCount, *command.shader);
+                    break;
+                case kern::CommandList::CommandType::DrawInstanced:
+                    endDrawCommands(current);
+                    drawInstancedData(*command.draw.mesh, command.data, command.count, command.stride, *command.shader);
+                    break;
+                case kern::CommandList::CommandType::Tri:
+                {
+                    endDrawCommands(current);
+                    const auto* shape = static_cast<const kern::CommandList::ShapeData*>(command.data);
+                    renderTri(shape->a, shape->b, shape->c, shape->color);
+                    break;
+                }
+                case kern::CommandList::CommandType::Line:
+                {
+                    endDrawCommands(current);
+                    const auto* shape = static_cast<const kern::CommandList::ShapeData*>(command.data);
+                    renderLine(shape->a, shape->b, shape->color, shape->size);
+                    break;
+                }
+                case kern::CommandList::CommandType::DrawSprites:
+                    endDrawCommands(current);
+                    drawSprites(command.texture, { static_cast<const kern::SpriteInstance*>(command.data), command.count });
+                    break;
+                case kern::CommandList::CommandType::Polyline:
+                {
+                    endDrawCommands(current);
+                    const auto* header = static_cast<const kern::CommandList::PolylineData*>(command.data);
+                    renderPolyline({ reinterpret_cast<const kern::Vector2*>(header + 1), command.count }, header->width, header->color, header->style);
+                    break;
+                }
+                case kern::CommandList::CommandType::Circle:
+                {
+                    endDrawCommands(current);
+                    const auto* shape = static_cast<const kern::CommandList::ShapeData*>(command.data);
+                    renderCircle(shape->a, shape->size, shape->color);
+                    break;
+                }
+                case kern::CommandList::CommandType::Rect:
+                {
+                    endDrawCommands(current);
+                    const auto* shape = static_cast<const kern::CommandList::ShapeData*>(command.data);
+                    renderRect(shape->a, shape->b, shape->size, shape->color);
+                    break;
+                }
+                case kern::CommandList::CommandType::Ellipse:
+                {
+                    endDrawCommands(current);
+                    const auto* shape = static_cast<const kern::CommandList::ShapeData*>(command.data);
+                    renderEllipse(shape->a, shape->b, shape->size, shape->color);
+                    break;
+                }
+                case kern::CommandList::CommandType::ClearColor:
+                {
+                    const auto* color = static_cast<const kern::Color*>(command.data);
+                    setClearColor(color->r, color->g, color->b, color->a);
+                    break;
+                }
+                case kern::CommandList::CommandType::Clear:
+                    endDrawCommands(current);
+                    clear();
+                    break;
+                case kern::CommandList::CommandType::SetCamera:
+                {
+                    endDrawCommands(current);
+                    const auto* camera = static_cast<const kern::CommandList::CameraData*>(command.data);
+                    setCamera(camera->view, camera->projection);
+                    break;
+                }
+                case kern::CommandList::CommandType::Invoke:
+                    endDrawCommands(current);
+                    // The callback may change any state behind the cache's back
+                    list->runCallback(command);
+                    current = {};
+                    break;
+            }
+        }
+    }
+
+    endDrawCommands(current);
+}
+
+void OpenGLRenderer::syncFrameConstants()
+{
+    if (!frameDirty)
+    {
+        return;
+    }
+
+    frameBlock.set(frameConstants);
+    frameDirty = false;
+}
+
 void OpenGLRenderer::setClearColor(float r, float g, float b, float a)
 {
     if (window)
@@ -76,143 +348,556 @@ void OpenGLRenderer::setClearColor(float r, float g, float b, float a)
 
 void OpenGLRenderer::renderTri(kern::Vector2 a, kern::Vector2 b, kern::Vector2 c, kern::Color color)
 {
-    // 2 floats for position, 3 floats for color
-    GLfloat vertices[] = {
-        a.x, a.y,  color.r, color.g, color.b,
-        b.x, b.y,  color.r, color.g, color.b,
-        c.x, c.y,  color.r, color.g, color.b
-    };
+    pushTri(a, b, c, color);
+}
+
+void OpenGLRenderer::pushTri(kern::Vector2 a, kern::Vector2 b, kern::Vector2 c, kern::Color color)
+{
+    // Shapes and triangles are separate batches, keep them in submission order
+    if (!shapeInstances.empty())
+    {
+        flushShapes();
+    }
+
+    if (batchVertices.size() + 3 > maxBatchVertices)
+    {
+        flushTriangles();
+    }
+
+    batchVertices.push_back({ a.x, a.y, color.r, color.g, color.b });
+    batchVertices.push_back({ b.x, b.y, color.r, color.g, color.b });
+    batchVertices.push_back({ c.x, c.y, color.r, color.g, color.b });
+}
+
+void OpenGLRenderer::pushShape(const ShapeInstance& shape)
+{
+    if (!batchVertices.empty())
+    {
+        flushTriangles();
+    }
+
+    if (shapeInstances.size() >= maxBatchShapes)
+    {
+        flushShapes();
+    }
+
+    shapeInstances.push_back(shape);
+}
+
+void OpenGLRenderer::flushBatch()
+{
+    // Every draw path flushes the batch first, so this runs before any draw
+    syncFrameConstants();
+
+    // At most one of the two holds anything, pushTri/pushShape flush the other
+    flushTriangles();
+    flushShapes();
+}
+
+void OpenGLRenderer::flushShapes()
+{
+    if (shapeInstances.empty())
+    {
+        return;
+    }
 
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    // Also reached from pushTri/pushShape, not only through flushBatch()
+    syncFrameConstants();
 
-    // Check for errors
-    if (VAO == 0 || VBO == 0) {
-        std::cerr << "Failed to generate VAO/VBO!" << std::endl;
+    const GLsizei count = static_cast<GLsizei>(shapeInstances.size());
+    GLintptr offset = streamData(shapeInstances.data(), shapeInstances.size() * sizeof(ShapeInstance), sizeof(float));
+    shapeInstances.clear();
+    if (offset < 0)
+    {
         return;
     }
 
-    glBindVertexArray(VAO);
+    bindInstancedQuads(shapeVao, offset, sizeof(ShapeInstance), 3);
+
+    // Edges are blended; like the triangle batch, shapes sit at z = 0 and
+    // shouldn't hide each other through the depth test
+    state.setDepthTest(false);
+    state.setBlend(true);
+    state.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    shapeProgram.bind();
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    frameStats.drawCalls++;
+
+    state.setBlend(false);
+    state.setDepthTest(true);
+}
+
+void OpenGLRenderer::bindInstancedQuads(GLuint& vao, GLintptr offset, GLsizei stride, GLuint attributes)
+{
+    const bool created = vao == 0;
+    if (created)
+    {
+        glGenVertexArrays(1, &vao);
+    }
+
+    state.bindVertexArray(vao);
+    state.bindBuffer(GL_ARRAY_BUFFER, streamBuffer.getBuffer());
+
+    // No base instance in GL 3.3, so the attributes follow the data's offset
+    for (GLuint i = 0; i < attributes; i++)
+    {
+        glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + i * 4 * sizeof(float)));
+        if (created)
+        {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+    }
+}
+
+void OpenGLRenderer::flushTriangles()
+{
+    if (batchVertices.empty())
+    {
+        return;
+    }
+
+    // Also reached from pushTri/pushShape, not only through flushBatch()
+    syncFrameConstants();
+
+    const GLsizei count = static_cast<GLsizei>(batchVertices.size());
+    GLint first = streamVertices(batchVertices.data(), batchVertices.size(), sizeof(BatchVertex));
+    batchVertices.clear();
+    if (first < 0)
+    {
+        return;
+    }
+
+    if (!batchVao.vao)
+    {
+        glGenVertexArrays(1, &batchVao.vao);
+    }
+
+    state.bindVertexArray(batchVao.vao);
+
+    if (batchVao.generation != streamBuffer.getGeneration())
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, streamBuffer.getBuffer());
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        // Position attribute
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (void*)offsetof(BatchVertex, x));
+        glEnableVertexAttribArray(0);
+
+        // Color attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (void*)offsetof(BatchVertex, r));
+        glEnableVertexAttribArray(1);
+
+        batchVao.generation = streamBuffer.getGeneration();
+    }
 
     triProgram.bind();
+    GL_CHECK(glDrawArrays(GL_TRIANGLES, first, count));
+    frameStats.drawCalls++;
+}
+
+GLintptr OpenGLRenderer::streamData(const void* data, size_t size, size_t alignment)
+{
+    size_t offset;
+
+    if (streamBuffer.owns(data, size))
+    {
+        // Written in place through map()
+        offset = streamBuffer.offsetOf(data);
+    }
+    else
+    {
+        kern::OpenGLStreamBuffer::Allocation allocation = streamBuffer.allocate(size, alignment);
+        if (!allocation.data)
+        {
+            return -1;
+        }
+        std::memcpy(allocation.data, data, size);
+        offset = allocation.offset;
+    }
+
+    streamBuffer.unmap();
+    return static_cast<GLintptr>(offset);
+}
+
+GLint OpenGLRenderer::streamVertices(const void* vertices, size_t vertexCount, size_t stride)
+{
+    GLintptr offset = streamData(vertices, vertexCount * stride, stride);
+    if (offset < 0)
+    {
+        return -1;
+    }
+    return static_cast<GLint>(static_cast<size_t>(offset) / stride);
+}
+
+GLintptr OpenGLRenderer::streamIndexed(const void* vertices, size_t vertexCount, size_t stride, const uint32_t* indices, size_t indexCount, GLint& baseVertex, GLenum& indexType)
+{
+    const bool narrow = vertexCount <= kern::maxShortIndexVertices;
+    const size_t indexSize = narrow ? sizeof(uint16_t) : sizeof(uint32_t);
+    const size_t vertexBytes = vertexCount * stride;
+
+    size_t vertexOffset;
+    size_t indexOffset;
+    uint8_t* indexData;
+
+    if (streamBuffer.owns(vertices, vertexBytes))
+    {
+        // Written in place through map(), only the indices need room. Should
+        // that grow the buffer, the vertices stay behind in the old storage
+        const uint32_t generation = streamBuffer.getGeneration();
+        vertexOffset = streamBuffer.offsetOf(vertices);
+
+        kern::OpenGLStreamBuffer::Allocation allocation = streamBuffer.allocate(indexCount * indexSize, indexSize);
+        if (streamBuffer.getGeneration() != generation)
+        {
+            cast("Stream buffer grew past mapped vertices, draw skipped", kern::DebugLevel::Warning);
+            streamBuffer.unmap();
+            return -1;
+        }
+        if (!allocation.data)
+        {
+            return -1;
+        }
+        indexOffset = allocation.offset;
+        indexData = static_cast<uint8_t*>(allocation.data);
+    }
+    else
+    {
+        // One allocation for both, so growing the buffer can't separate them.
+        // Its offset is a multiple of the stride and of the index size.
+        const size_t indexStart = (vertexBytes + indexSize - 1) / indexSize * indexSize;
+        kern::OpenGLStreamBuffer::Allocation allocation = streamBuffer.allocate(indexStart + indexCount * indexSize, std::lcm(stride, indexSize));
+        if (!allocation.data)
+        {
+            return -1;
+        }
+        std::memcpy(allocation.data, vertices, vertexBytes);
+        vertexOffset = allocation.offset;
+        indexOffset = allocation.offset + indexStart;
+        indexData = static_cast<uint8_t*>(allocation.data) + indexStart;
+    }
+
+    if (narrow)
+    {
+        uint16_t* dst = reinterpret_cast<uint16_t*>(indexData);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            dst[i] = static_cast<uint16_t>(indices[i]);
+        }
+        indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        std::memcpy(indexData, indices, indexCount * indexSize);
+        indexType = GL_UNSIGNED_INT;
+    }
 
-    // Ensure program is valid
-    if (!triProgram.getId()) {
-        cast("Shader program ID is 0!", kern::DebugLevel::Error);
+    streamBuffer.unmap();
+    baseVertex = static_cast<GLint>(vertexOffset / stride);
+    return static_cast<GLintptr>(indexOffset);
+}
+
+void OpenGLRenderer::bindStreamLayout(const kern::VertexLayout& layout)
+{
+    StreamVao& entry = vaoCache[layout.getHash()];
+    if (!entry.vao)
+    {
+        glGenVertexArrays(1, &entry.vao);
+    }
+
+    state.bindVertexArray(entry.vao);
+
+    if (entry.generation == streamBuffer.getGeneration())
+    {
         return;
     }
 
-    GLint linked;
-    glGetProgramiv(triProgram.getId(), GL_LINK_STATUS, &linked);
+    state.bindBuffer(GL_ARRAY_BUFFER, streamBuffer.getBuffer());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streamBuffer.getBuffer());
+
+    kern::bindVertexAttributes(layout, false);
 
-    if (!linked)
+    entry.generation = streamBuffer.getGeneration();
+}
+
+const kern::VertexLayout& OpenGLRenderer::resolveLayout(const kern::Mesh& mesh, const kern::OpenGLShaderProgram& shader) const
+{
+    // The shader's layout decides attribute indices; fall back to the mesh's own
+    return shader.getVertexLayout().empty() ? mesh.getLayout() : shader.getVertexLayout();
+}
+
+void OpenGLRenderer::drawVertices(const void* vertices, size_t count, size_t stride, const kern::OpenGLShaderProgram& shader)
+{
+    if (count == 0) return;
+
+    const kern::VertexLayout& layout = shader.getVertexLayout();
+    if (layout.getStride() != stride) {
+        cast("Vertex size mismatch!", kern::DebugLevel::Error);
+        return;
+    }
+
+    // Keep submission order: pending 2D shapes go out before this draw. This
+    // also has to come before streaming, flushing can grow the stream buffer
+    flushBatch();
+
+    GLint first = streamVertices(vertices, count, stride);
+    if (first < 0) return;
+
+    shader.bind();
+    bindStreamLayout(layout);
+    glDrawArrays(GL_TRIANGLES, first, static_cast<GLint>(count));
+    frameStats.drawCalls++;
+}
+
+void OpenGLRenderer::drawIndexedVertices(const void* vertices, size_t vertexCount, size_t stride, const uint32_t* indices, size_t indexCount, const kern::OpenGLShaderProgram& shader)
+{
+    if (vertexCount == 0 || indexCount == 0) return;
+
+    const kern::VertexLayout& layout = shader.getVertexLayout();
+    if (layout.getStride() != stride) {
+        cast("Vertex size mismatch!", kern::DebugLevel::Error);
+        return;
+    }
+
+    // Before streaming, flushing can grow the stream buffer
+    flushBatch();
+
+    GLint baseVertex;
+    GLenum indexType;
+    GLintptr indexOffset = streamIndexed(vertices, vertexCount, stride, indices, indexCount, baseVertex, indexType);
+    if (indexOffset < 0) return;
+
+    shader.bind();
+    bindStreamLayout(layout);
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(indexCount), indexType, (void*)indexOffset, baseVertex);
+    frameStats.drawCalls++;
+}
+
+void OpenGLRenderer::drawInstancedData(const kern::Mesh& mesh, const void* instances, size_t count, size_t stride, const kern::OpenGLShaderProgram& shader)
+{
+    if (count == 0) return;
+
+    const kern::VertexLayout& layout = resolveLayout(mesh, shader);
+    if (layout.getInstanceStride() != stride) {
+        cast("Instance size mismatch!", kern::DebugLevel::Error);
+        return;
+    }
+
+    // Before streaming, flushing can grow the stream buffer
+    flushBatch();
+
+    // Attribute offsets only need 4-byte alignment
+    GLintptr offset = streamData(instances, count * stride, sizeof(float));
+    if (offset < 0) return;
+
+    drawInstancedFromStream(mesh, layout, static_cast<size_t>(offset), count, shader);
+}
+
+void OpenGLRenderer::draw(kern::SpriteBatch& batch)
+{
+    batch.sort();
+    for (const kern::SpriteBatch::Range& range : batch.getRanges())
     {
-        GLchar log[512];
-        glGetProgramInfoLog(triProgram.getId(), 512, nullptr, log);
-        cast("Link log: " + std::string(log), kern::DebugLevel::Error);
+        drawSprites(range.texture, range.instances);
     }
+}
+
+void OpenGLRenderer::drawSprites(GLuint texture, std::span<const kern::SpriteInstance> sprites)
+{
+    if (!texture || sprites.empty()) return;
+
+    flushBatch();
 
-    // Position attribute
-    GL_CHECK(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0));
-    GL_CHECK(glEnableVertexAttribArray(0));
+    GLintptr offset = streamData(sprites.data(), sprites.size_bytes(), sizeof(float));
+    if (offset < 0) return;
 
-    // Color attribute
-    GL_CHECK(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float))));
-    GL_CHECK(glEnableVertexAttribArray(1));
+    bindInstancedQuads(spriteVao, offset, sizeof(kern::SpriteInstance), 4);
 
-    glBindVertexArray(0);
+    state.setDepthTest(false);
+    state.setBlend(true);
+    state.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    state.bindTexture(0, GL_TEXTURE_2D, texture);
 
-    // Draw
-    glBindVertexArray(VAO);
-    GL_CHECK(glDrawArrays(GL_TRIANGLES, 0, 3));
+    // u_Texture keeps its default of unit 0
+    spriteProgram.bind();
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(sprites.size()));
+    frameStats.drawCalls++;
 
-    // Cleanup
-    glBindVertexArray(0);
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    state.setBlend(false);
+    state.setDepthTest(true);
 }
 
-void OpenGLRenderer::bindVertexData(const void* vertices, size_t vertexCount, const kern::VertexLayout& layout)
+void OpenGLRenderer::draw(const kern::Mesh& mesh, const kern::OpenGLShaderProgram& shader)
 {
-    size_t hash = std::hash<size_t>{}(layout.getStride()); // Simplified hash
-    // In practice, hash over element names/types
+    if (mesh.isIndexed())
+    {
+        drawIndexed(mesh, shader);
+        return;
+    }
 
-    GLuint vbo = 0, vao = 0;
+    if (!mesh.isValid() || mesh.getVertexCount() == 0) return;
 
-    if (vboCache.count(hash)) {
-        vbo = vboCache[hash];
-        vao = vaoCache[hash];
-    } else {
-        glGenBuffers(1, &vbo);
-        glGenVertexArrays(1, &vao);
+    const kern::VertexLayout& layout = resolveLayout(mesh, shader);
+    if (layout.getStride() != mesh.getStride()) {
+        cast("Vertex size mismatch!", kern::DebugLevel::Error);
+        return;
+    }
+
+    flushBatch();
+
+    shader.bind();
+    mesh.bind(layout);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(mesh.getVertexCount()));
+    frameStats.drawCalls++;
+}
+
+void OpenGLRenderer::drawIndexed(const kern::Mesh& mesh, const kern::OpenGLShaderProgram& shader)
+{
+    if (!mesh.isIndexed() || mesh.getIndexCount() == 0) return;
+
+    const kern::VertexLayout& layout = resolveLayout(mesh, shader);
+    if (layout.getStride() != mesh.getStride()) {
+        cast("Vertex size mismatch!", kern::DebugLevel::Error);
+        return;
+    }
+
+    flushBatch();
+
+    shader.bind();
+    mesh.bind(layout);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.getIndexCount()), mesh.getIndexType(), nullptr);
+    frameStats.drawCalls++;
+}
+
+void OpenGLRenderer::drawInstancedFromStream(const kern::Mesh& mesh, const kern::VertexLayout& layout, size_t instanceOffset, size_t instanceCount, const kern::OpenGLShaderProgram& shader)
+{
+    if (!mesh.isValid()) return;
 
-        vboCache[hash] = vbo;
-        vaoCache[hash] = vao;
+    if (layout.getStride() != mesh.getStride()) {
+        cast("Vertex size mismatch!", kern::DebugLevel::Error);
+        return;
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, layout.getStride() * vertexCount, vertices, GL_STATIC_DRAW);
+    shader.bind();
+    mesh.bind(layout);
 
-    glBindVertexArray(vao);
+    // Instance attributes follow this frame's data in the stream buffer
+    state.bindBuffer(GL_ARRAY_BUFFER, streamBuffer.getBuffer());
+    kern::bindVertexAttributes(layout, true, instanceOffset);
 
-    const auto& elements = layout.getElements();
-    for (const auto& elem : elements) {
-        glEnableVertexAttribArray(elem.index);
-        glVertexAttribPointer(
-            elem.index, 
-            elem.getTypeComponentCount(),
-            GL_FLOAT,
-            GL_FALSE,
-            layout.getStride(),
-            (void*)elem.offset
-        );
+    const GLsizei instances = static_cast<GLsizei>(instanceCount);
+    if (mesh.isIndexed())
+    {
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(mesh.getIndexCount()), mesh.getIndexType(), nullptr, instances);
+    }
+    else
+    {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(mesh.getVertexCount()), instances);
     }
+    frameStats.drawCalls++;
 }
 
 void OpenGLRenderer::renderLine(kern::Vector2 a, kern::Vector2 b, kern::Color color, float thickness)
 {
-    kern::Vector2 dir = (b - a).normalized();
-    kern::Vector2 n = kern::Vector2(-dir.y, dir.x) * (thickness * 0.002f);
-    kern::Vector2 
-    v0 = a + n,
-    v1 = a - n,
-    v2 = b - n,
-    v3 = b + n;
+    const kern::Vector2 points[] = { a, b };
+    renderPolyline(points, thickness, color, {});
+}
+
+void OpenGLRenderer::renderPolyline(std::span<const kern::Vector2> points, float thickness, kern::Color color, const kern::PolylineStyle& style)
+{
+    polylineTriangles.clear();
+    kern::expandPolyline(points, thickness, style, kern::Vector2(width * 0.5f, height * 0.5f), polylineTriangles);
+    if (polylineTriangles.empty())
+    {
+        return;
+    }
 
-    renderTri(v0, v1, v2, color);
-    renderTri(v2, v3, v0, color);
+    if (!shapeInstances.empty())
+    {
+        flushShapes();
+    }
+
+    // A polyline is never split: flush what's pending instead, and let a
+    // single long one exceed the batch limit
+    if (!batchVertices.empty() && batchVertices.size() + polylineTriangles.size() > maxBatchVertices)
+    {
+        flushTriangles();
+    }
+
+    batchVertices.reserve(batchVertices.size() + polylineTriangles.size());
+    for (const kern::Vector2& p : polylineTriangles)
+    {
+        batchVertices.push_back({ p.x, p.y, color.r, color.g, color.b });
+    }
 }
 
 void OpenGLRenderer::renderCircle(kern::Vector2 center, float radius, kern::Color color)
 {
-    int segments = 32;
-    float step = 3.1415926535 * 2 / segments;
+    renderEllipse(center, kern::Vector2(radius, radius), 0.0f, color);
+}
+
+void OpenGLRenderer::renderRect(kern::Vector2 position, kern::Vector2 size, float cornerRadius, kern::Color color)
+{
+    const kern::Vector2 halfSize(std::abs(size.x) * 0.5f, std::abs(size.y) * 0.5f);
+    const kern::Vector2 center = position + size * 0.5f;
+
+    pushShape({
+        center.x, center.y, halfSize.x, halfSize.y,
+        color.r, color.g, color.b, color.a,
+        std::max(cornerRadius, 0.0f), float(ShapeType::Rect), 0.0f, 0.0f
+    });
+}
 
-    for (int i = 0; i < segments; i++) {
-        float a0 = i * step;
-        float a1 = (i + 1) * step;
+void OpenGLRenderer::renderEllipse(kern::Vector2 center, kern::Vector2 radii, float thickness, kern::Color color)
+{
+    pushShape({
+        center.x, center.y, std::abs(radii.x), std::abs(radii.y),
+        color.r, color.g, color.b, color.a,
+        std::max(thickness, 0.0f), float(ShapeType::Ellipse), 0.0f, 0.0f
+    });
+}
+
+void OpenGLRenderer::resize(int w, int h)
+{
+    externalSize = true;
+    externalWidth = w;
+    externalHeight = h;
+}
 
-        kern::Vector2 p0 = center;
-        kern::Vector2 p1 = center + kern::Vector2(cos(a0), sin(a0)) * radius;
-        kern::Vector2 p2 = center + kern::Vector2(cos(a1), sin(a1)) * radius;
+void OpenGLRenderer::setOffscreen(bool enabled)
+{
+    if (enabled == offscreen.isValid()) return;
 
-        renderTri(p0, p1, p2, color);
+    flushBatch();
+    if (enabled)
+    {
+        offscreen = kern::OpenGLFramebuffer(width, height);
+        offscreen.bind();
+    }
+    else
+    {
+        offscreen = kern::OpenGLFramebuffer();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 }
 
 void OpenGLRenderer::updateViewport()
 {
-    int w, h;
-    glfwGetWindowSize(static_cast<GLFWwindow*>(window), &w, &h);
+    int w = externalWidth, h = externalHeight;
+    if (!externalSize)
+    {
+        glfwGetWindowSize(static_cast<GLFWwindow*>(window), &w, &h);
+    }
 
     if (w != width || h != height)
     {
         width = w;
         height = h;
-        glViewport(0, 0, width, height);
+        state.setViewport(0, 0, width, height);
+        if (offscreen.isValid()) offscreen.resize(width, height);
+
+        frameConstants.viewport[2] = static_cast<float>(width);
+        frameConstants.viewport[3] = static_cast<float>(height);
+        frameDirty = true;
     }
 }
\ No newline at end of file
@@ -7,6 +7,18 @@
 #include "backends/renderer.h"
 #include "utils/shaders.h"
 #include "utils/vertexlayout.h"
+#include "utils/mesh.h"
+#include "utils/uniformblock.h"
+#include "utils/renderqueue.h"
+#include "utils/commandlist.h"
+#include "utils/spritebatch.h"
+#include "utils/textureloader.h"
+#include "utils/resourcemanager.h"
+#include "utils/shaderlibrary.h"
+#include "backends/OpenGL/openglstreambuffer.h"
+#include "backends/OpenGL/openglstate.h"
+#include "backends/OpenGL/openglframebuffer.h"
+#include <span>
 #include <unordered_map>
 
 #include "config.h"
@@ -16,42 +28,212 @@ class OpenGLRenderer : public Renderer
 {
 public:
     OpenGLRenderer(GLFWwindow* window, int width, int height);
-    ~OpenGLRenderer() override = default;
+    ~OpenGLRenderer() override;
 
     void clear() override;
     void present() override;
     void setClearColor(float r, float g, float b, float a) override;
     void renderTri(kern::Vector2 a, kern::Vector2 b, kern::Vector2 c, kern::Color color) override;
     void renderLine(kern::Vector2 a, kern::Vector2 b, kern::Color color, float thickness) override;
+    void renderPolyline(std::span<const kern::Vector2> points, float thickness, kern::Color color, const kern::PolylineStyle& style) override;
     void renderCircle(kern::Vector2 center, float radius, kern::Color color) override;
+    void renderRect(kern::Vector2 position, kern::Vector2 size, float cornerRadius, kern::Color color) override;
+    void renderEllipse(kern::Vector2 center, kern::Vector2 radii, float thickness, kern::Color color) override;
+    kern::RenderStats getStats() const override { return lastFrameStats; }
+
+    // Fills the view and projection of the KernFrame block, uploaded once
+    // for every program that declares it
+    void setCamera(const kern::Mat4& view, const kern::Mat4& projection);
+
+    // Size the viewport follows from now on, instead of querying GLFW, which
+    // is only allowed on the main thread
+    void resize(int width, int height);
+    void useWindowSize() { externalSize = false; }
+
+    // Renders into an offscreen framebuffer instead of the window, which is
+    // then never swapped. Used by GraphicsAPI::OpenGLHeadless.
+    void setOffscreen(bool enabled);
+    bool isOffscreen() const { return offscreen.isValid(); }
+
+    // Last presented frame as RGBA8, top row first; empty unless offscreen
+    std::vector<uint8_t> readPixels() const { return offscreen.readPixels(); }
+
+    // Deferred draw, sorted with the rest of the frame's commands at present()
+    void submit(const kern::DrawCommand& command) { queue.submit(command); }
+
+    // Writable vertex memory straight inside the stream buffer. Pass the span
+    // to draw() to skip the copy. Without ARB_buffer_storage only the most
+    // recent map() stays writable, so draw it before mapping again.
+    // Pending 2D shapes are flushed first, so that draw() doesn't flush (and
+    // allocate over this span) itself.
+    template<typename Vertex>
+    std::span<Vertex> map(size_t count)
+    {
+        flushBatch();
+        kern::OpenGLStreamBuffer::Allocation allocation = streamBuffer.allocate(count * sizeof(Vertex), sizeof(Vertex));
+        if (!allocation.data) return {};
+        return { static_cast<Vertex*>(allocation.data), count };
+    }
+
+    template<typename Vertex>
+    void draw(std::span<const Vertex> vertices, const kern::OpenGLShaderProgram& shader)
+    {
+        drawVertices(vertices.data(), vertices.size(), sizeof(Vertex), shader);
+    }
 
     template<typename Vertex>
     void draw(const std::vector<Vertex>& vertices, const kern::OpenGLShaderProgram& shader)
     {
-        if (vertices.empty()) return;
+        draw(std::span<const Vertex>(vertices), shader);
+    }
+
+    // Indices are narrowed to 16 bits in the stream whenever the vertex count allows
+    template<typename Vertex>
+    void drawIndexed(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const kern::OpenGLShaderProgram& shader)
+    {
+        drawIndexedVertices(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size(), shader);
+    }
 
-        const kern::VertexLayout& layout = shader.getVertexLayout();
-        if (layout.getStride() != sizeof(Vertex)) {
-            cast("Vertex size mismatch!", kern::DebugLevel::Error);
-            return;
-        }
+    void draw(const kern::Mesh& mesh, const kern::OpenGLShaderProgram& shader);
+    void drawIndexed(const kern::Mesh& mesh, const kern::OpenGLShaderProgram& shader);
 
-        shader.bind();
-        bindVertexData(vertices.data(), vertices.size(), layout);
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLint>(vertices.size()));
-        glBindVertexArray(0);
+    // One draw call for every instance; the instance data is uploaded once
+    // and fed to the layout's addInstanced() elements
+    template<typename Instance>
+    void drawInstanced(const kern::Mesh& mesh, std::span<const Instance> instances, const kern::OpenGLShaderProgram& shader)
+    {
+        drawInstancedData(mesh, instances.data(), instances.size(), sizeof(Instance), shader);
     }
 
+    // Sorts the batch and draws it, one instanced draw per range
+    void draw(kern::SpriteBatch& batch);
+    void drawSprites(GLuint texture, std::span<const kern::SpriteInstance> sprites);
+
+    // Executes the lists in the given order on this (the GL) thread, no matter
+    // in which order the workers finished recording them
+    void submit(const kern::CommandList& list);
+    void submit(std::span<const kern::CommandList* const> lists);
+
 private:
+    // Matches the built-in tri shader: vec2 position + vec3 color
+    struct BatchVertex
+    {
+        float x, y;
+        float r, g, b;
+    };
+
+    // Flush once this many vertices are pending (~1 MB of vertex data)
+    static constexpr size_t maxBatchVertices = 3 * 16384;
+
+    // Matches the built-in shape shader; one instanced quad per shape whose
+    // edge is computed from a signed distance in the fragment shader
+    enum class ShapeType
+    {
+        Rect = 0,     // Rounded when cornerRadius > 0
+        Ellipse = 1   // A ring when thickness > 0
+    };
+
+    struct ShapeInstance
+    {
+        float centerX, centerY, halfWidth, halfHeight;
+        float r, g, b, a;
+        float size;   // Corner radius or ring thickness
+        float type;
+        float padding[2];
+    };
+
+    static constexpr size_t maxBatchShapes = 16384;
+
     GLFWwindow* window;
     int width, height;
+    bool externalSize = false;
+    int externalWidth = 0, externalHeight = 0;
+    kern::OpenGLFramebuffer offscreen;
+
+    // Shadowed GL state, published through kern::glState while alive
+    kern::OpenGLStateCache state;
+    kern::RenderStats frameStats;
+    kern::RenderStats lastFrameStats;
+
+    kern::RenderQueue queue;
+    kern::TextureLoader textureLoader;
+    kern::ResourceManager resources;
+
+    // Per-frame constants, re-uploaded before the next draw after a change
+    kern::UniformBlock<kern::FrameConstants> frameBlock;
+    kern::FrameConstants frameConstants;
+    bool frameDirty = true;
+    double lastPresentTime = 0.0;
+
+    // Built-in sources plus user variants; declared before the programs
+    // below, which are built from it
+    kern::ShaderLibrary shaderLibrary;
 
     // Remove default initialization
     kern::OpenGLShaderProgram triProgram;
+    kern::OpenGLShaderProgram shapeProgram;
+    kern::OpenGLShaderProgram spriteProgram;
+
+    // All per-frame vertex data (batch and draw<Vertex>) is streamed from here
+    kern::OpenGLStreamBuffer streamBuffer;
+
+    // VAOs pointing into the stream buffer keyed by layout hash, re-pointed
+    // when the buffer is recreated
+    struct StreamVao
+    {
+        GLuint vao = 0;
+        uint32_t generation = 0;
+    };
+    std::unordered_map<size_t, StreamVao> vaoCache;
+
+    // Per-frame batch for tri/line/circle, drawn in as few calls as possible
+    std::vector<BatchVertex> batchVertices;
+    StreamVao batchVao;
+    std::vector<kern::Vector2> polylineTriangles;
+
+    // Per-frame batch for SDF shapes; its VAO is re-pointed on every flush
+    std::vector<ShapeInstance> shapeInstances;
+    GLuint shapeVao = 0;
+    GLuint spriteVao = 0;
 
-    mutable std::unordered_map<size_t, GLuint> vboCache;
-    mutable std::unordered_map<size_t, GLuint> vaoCache;
+    void pushTri(kern::Vector2 a, kern::Vector2 b, kern::Vector2 c, kern::Color color);
+    void pushShape(const ShapeInstance& shape);
+    // Sends whichever 2D batch is pending
+    void flushBatch();
+    void flushTriangles();
+    void flushShapes();
+    // Points `attributes` vec4 per-instance attributes at the stream buffer,
+    // for the built-in shaders that draw one 4-vertex strip per instance
+    void bindInstancedQuads(GLuint& vao, GLintptr offset, GLsizei stride, GLuint attributes);
 
-    void bindVertexData(const void* vertices, size_t vertexCount, const kern::VertexLayout& layout);
+    // Returns the byte offset of the data in the stream buffer, or -1 on failure.
+    // Data written through map() is used in place.
+    GLintptr streamData(const void* data, size_t size, size_t alignment);
+    // Returns the first vertex index in the stream buffer, or -1 on failure
+    GLint streamVertices(const void* vertices, size_t vertexCount, size_t stride);
+    // Streams vertices and indices together. Returns the byte offset of the
+    // indices in the stream buffer, or -1 on failure.
+    GLintptr streamIndexed(const void* vertices, size_t vertexCount, size_t stride, const uint32_t* indices, size_t indexCount, GLint& baseVertex, GLenum& indexType);
+    const kern::VertexLayout& resolveLayout(const kern::Mesh& mesh, const kern::OpenGLShaderProgram& shader) const;
+    // The 2D batch must be flushed before the instances were streamed
+    void drawInstancedFromStream(const kern::Mesh& mesh, const kern::VertexLayout& layout, size_t instanceOffset, size_t instanceCount, const kern::OpenGLShaderProgram& shader);
+    void bindStreamLayout(const kern::VertexLayout& layout);
+    void drawVertices(const void* vertices, size_t count, size_t stride, const kern::OpenGLShaderProgram& shader);
+    void drawIndexedVertices(const void* vertices, size_t vertexCount, size_t stride, const uint32_t* indices, size_t indexCount, const kern::OpenGLShaderProgram& shader);
+    void drawInstancedData(const kern::Mesh& mesh, const void* instances, size_t count, size_t stride, const kern::OpenGLShaderProgram& shader);
+
+    // Applies a DrawCommand's model/texture/blend state and draws it,
+    // shared by the sorted queue and command lists
+    struct CommandState
+    {
+        kern::OpenGLShaderProgram* shader = nullptr;
+        kern::UniformHandle modelUniform;
+        kern::UniformHandle textureUniform;
+        bool blending = false;
+    };
+    void executeDrawCommand(const kern::DrawCommand& command, CommandState& current);
+    void endDrawCommands(CommandState& current);
     void updateViewport();
+    void syncFrameConstants();
+    void executeQueue();
 };
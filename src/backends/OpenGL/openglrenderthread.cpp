@@ -0,0 +1,70 @@
+#include "openglrenderthread.h"
+#include "openglrenderer.h"
+#include "config.h"
+
+kern::OpenGLRenderThread::OpenGLRenderThread(MakeCurrent makeCurrent, OpenGLRenderer* renderer)
+    : makeCurrent(std::move(makeCurrent)), renderer(renderer)
+{
+    for (FramePacket& packet : packets)
+    {
+        freePackets.push(&packet);
+    }
+
+    thread = std::thread(&OpenGLRenderThread::run, this);
+    cast("Render thread started");
+}
+
+kern::OpenGLRenderThread::~OpenGLRenderThread()
+{
+    readyPackets.push(nullptr);
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+    makeCurrent(true);
+    cast("Render thread stopped");
+}
+
+kern::FramePacket* kern::OpenGLRenderThread::acquire()
+{
+    FramePacket* packet = freePackets.pop();
+
+    // Written by the render thread before it released the packet
+    if (packet->rendered)
+    {
+        lastStats = packet->stats;
+        packet->rendered = false;
+    }
+
+    packet->commands.reset();
+    return packet;
+}
+
+void kern::OpenGLRenderThread::submit(FramePacket* packet)
+{
+    if (packet)
+    {
+        readyPackets.push(packet);
+    }
+}
+
+void kern::OpenGLRenderThread::run()
+{
+    makeCurrent(true);
+
+    while (FramePacket* packet = readyPackets.pop())
+    {
+        renderer->resize(packet->width, packet->height);
+        renderer->submit(packet->commands);
+        renderer->present();
+
+        packet->stats = renderer->getStats();
+        packet->rendered = true;
+        freePackets.push(packet);
+    }
+
+    // Let the GPU finish before another thread takes over the context
+    glFinish();
+    makeCurrent(false);
+}
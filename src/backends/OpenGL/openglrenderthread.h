@@ -0,0 +1,65 @@
+// src/backends/OpenGL/openglrenderthread.h
+#pragma once
+
+#include <glad/glad.h>
+#include <functional>
+#include <thread>
+#include "backends/renderer.h"
+#include "utils/commandlist.h"
+#include "utils/spscqueue.h"
+
+class OpenGLRenderer;
+
+namespace kern
+{
+    // Everything the render thread needs to draw one frame
+    struct FramePacket
+    {
+        CommandList commands;
+        int width = 0, height = 0;  // Window size sampled on the app thread
+        RenderStats stats;          // Filled in by the render thread once presented
+        bool rendered = false;
+    };
+
+    // Owns the GL context on its own thread and renders the packets the app
+    // thread records. Three packets rotate between the threads, so the app can
+    // record frame N+1 while frame N renders and frame N-1 is being recycled.
+    class OpenGLRenderThread
+    {
+    public:
+        static constexpr size_t packetCount = 3;
+
+        // Makes the context current on the calling thread, or releases it
+        using MakeCurrent = std::function<void(bool current)>;
+
+        // The context must not be current on the calling thread
+        OpenGLRenderThread(MakeCurrent makeCurrent, OpenGLRenderer* renderer);
+        // Waits for queued frames, then makes the context current on the caller again
+        ~OpenGLRenderThread();
+
+        OpenGLRenderThread(const OpenGLRenderThread&) = delete;
+        OpenGLRenderThread& operator=(const OpenGLRenderThread&) = delete;
+
+        // App thread: a cleared packet to record into; blocks while all
+        // packets are in flight
+        FramePacket* acquire();
+        // App thread: hands a recorded packet over to be rendered
+        void submit(FramePacket* packet);
+
+        // Stats of the most recent frame whose packet came back
+        const RenderStats& getStats() const { return lastStats; }
+
+    private:
+        MakeCurrent makeCurrent;
+        OpenGLRenderer* renderer;
+
+        FramePacket packets[packetCount];
+        SpscQueue<FramePacket*, 4> freePackets;   // Render thread -> app thread
+        SpscQueue<FramePacket*, 4> readyPackets;  // App thread -> render thread, nullptr stops
+
+        RenderStats lastStats;
+        std::thread thread;
+
+        void run();
+    };
+}
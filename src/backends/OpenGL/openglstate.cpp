@@ -0,0 +1,182 @@
+#include "openglstate.h"
+
+void kern::OpenGLStateCache::invalidate()
+{
+    program = unknown;
+    vertexArray = unknown;
+    arrayBuffer = unknown;
+    uniformBuffer = unknown;
+    pixelUnpackBuffer = unknown;
+    for (unsigned int i = 0; i < maxUniformBindings; i++)
+    {
+        uniformBindings[i] = unknown;
+    }
+
+    activeUnit = unknown;
+    for (unsigned int i = 0; i < maxTextureUnits; i++)
+    {
+        textureTargets[i] = 0;
+        textures[i] = unknown;
+        samplers[i] = unknown;
+    }
+
+    blend = -1;
+    blendSrc = blendDst = 0;
+    depthTest = -1;
+    depthFunc = 0;
+    depthMask = -1;
+    viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+}
+
+void kern::OpenGLStateCache::useProgram(GLuint id)
+{
+    if (filter(program == id)) return;
+    glUseProgram(id);
+    program = id;
+}
+
+void kern::OpenGLStateCache::bindVertexArray(GLuint vao)
+{
+    if (filter(vertexArray == vao)) return;
+    glBindVertexArray(vao);
+    vertexArray = vao;
+}
+
+void kern::OpenGLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint* slot = nullptr;
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:        slot = &arrayBuffer; break;
+        case GL_UNIFORM_BUFFER:      slot = &uniformBuffer; break;
+        case GL_PIXEL_UNPACK_BUFFER: slot = &pixelUnpackBuffer; break;
+        default: break;
+    }
+
+    if (slot && filter(*slot == buffer)) return;
+    if (!slot) stats.issued++;
+
+    glBindBuffer(target, buffer);
+    if (slot) *slot = buffer;
+}
+
+void kern::OpenGLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    const bool tracked = target == GL_UNIFORM_BUFFER && index < maxUniformBindings;
+    if (tracked && filter(uniformBindings[index] == buffer)) return;
+    if (!tracked) stats.issued++;
+
+    glBindBufferBase(target, index, buffer);
+    if (tracked) uniformBindings[index] = buffer;
+    if (target == GL_UNIFORM_BUFFER) uniformBuffer = buffer;
+}
+
+void kern::OpenGLStateCache::setActiveUnit(unsigned int unit)
+{
+    if (filter(activeUnit == unit)) return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeUnit = unit;
+}
+
+void kern::OpenGLStateCache::bindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+    if (unit >= maxTextureUnits)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        activeUnit = unknown;
+        stats.issued += 2;
+        return;
+    }
+
+    if (filter(textures[unit] == texture && textureTargets[unit] == target)) return;
+
+    setActiveUnit(unit);
+    glBindTexture(target, texture);
+    textures[unit] = texture;
+    textureTargets[unit] = target;
+}
+
+void kern::OpenGLStateCache::bindSampler(unsigned int unit, GLuint sampler)
+{
+    if (unit < maxTextureUnits && filter(samplers[unit] == sampler)) return;
+    glBindSampler(unit, sampler);
+    if (unit < maxTextureUnits) samplers[unit] = sampler;
+}
+
+void kern::OpenGLStateCache::setBlend(bool enabled)
+{
+    if (filter(blend == int(enabled))) return;
+    enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    blend = enabled;
+}
+
+void kern::OpenGLStateCache::setBlendFunc(GLenum src, GLenum dst)
+{
+    if (filter(blendSrc == src && blendDst == dst)) return;
+    glBlendFunc(src, dst);
+    blendSrc = src;
+    blendDst = dst;
+}
+
+void kern::OpenGLStateCache::setDepthTest(bool enabled)
+{
+    if (filter(depthTest == int(enabled))) return;
+    enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    depthTest = enabled;
+}
+
+void kern::OpenGLStateCache::setDepthFunc(GLenum func)
+{
+    if (filter(depthFunc == func)) return;
+    glDepthFunc(func);
+    depthFunc = func;
+}
+
+void kern::OpenGLStateCache::setDepthMask(bool enabled)
+{
+    if (filter(depthMask == int(enabled))) return;
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    depthMask = enabled;
+}
+
+void kern::OpenGLStateCache::setViewport(int x, int y, int width, int height)
+{
+    if (filter(viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height)) return;
+    glViewport(x, y, width, height);
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+}
+
+void kern::OpenGLStateCache::onProgramDeleted(GLuint id)
+{
+    // GL keeps a deleted program in use until another one is bound
+    if (program == id) program = unknown;
+}
+
+void kern::OpenGLStateCache::onVertexArrayDeleted(GLuint vao)
+{
+    // Deleting the bound VAO reverts the binding to 0
+    if (vertexArray == vao) vertexArray = 0;
+}
+
+void kern::OpenGLStateCache::onBufferDeleted(GLuint buffer)
+{
+    if (arrayBuffer == buffer) arrayBuffer = 0;
+    if (uniformBuffer == buffer) uniformBuffer = 0;
+    if (pixelUnpackBuffer == buffer) pixelUnpackBuffer = 0;
+    for (unsigned int i = 0; i < maxUniformBindings; i++)
+    {
+        if (uniformBindings[i] == buffer) uniformBindings[i] = 0;
+    }
+}
+
+void kern::OpenGLStateCache::onTextureDeleted(GLuint texture)
+{
+    for (unsigned int i = 0; i < maxTextureUnits; i++)
+    {
+        if (textures[i] == texture) textures[i] = 0;
+    }
+}
@@ -0,0 +1,134 @@
+// src/backends/OpenGL/openglstate.h
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+
+namespace kern
+{
+    // Shadows the GL binding and fixed-function state Kern touches, so only
+    // real changes reach the driver. Owned by the renderer; anything that
+    // changes this state behind its back must call invalidate().
+    class OpenGLStateCache
+    {
+    public:
+        static constexpr unsigned int maxTextureUnits = 32;
+        static constexpr unsigned int maxUniformBindings = 16;
+
+        struct Stats
+        {
+            uint64_t issued = 0;   // Calls that reached GL
+            uint64_t skipped = 0;  // Redundant calls filtered out
+        };
+
+        OpenGLStateCache() { invalidate(); }
+
+        void useProgram(GLuint program);
+        void bindVertexArray(GLuint vao);
+        // Tracks GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER and GL_PIXEL_UNPACK_BUFFER;
+        // other targets pass straight through
+        void bindBuffer(GLenum target, GLuint buffer);
+        // Indexed GL_UNIFORM_BUFFER binding; also moves the generic binding
+        void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+        void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+        void bindSampler(unsigned int unit, GLuint sampler);
+
+        void setBlend(bool enabled);
+        void setBlendFunc(GLenum src, GLenum dst);
+        void setDepthTest(bool enabled);
+        void setDepthFunc(GLenum func);
+        void setDepthMask(bool enabled);
+        void setViewport(int x, int y, int width, int height);
+
+        // A deleted name can be handed out again, so forget it
+        void onProgramDeleted(GLuint program);
+        void onVertexArrayDeleted(GLuint vao);
+        void onBufferDeleted(GLuint buffer);
+        void onTextureDeleted(GLuint texture);
+
+        // Forget everything; the next call of each kind always reaches GL
+        void invalidate();
+
+        const Stats& getStats() const { return stats; }
+        void resetStats() { stats = {}; }
+
+    private:
+        // Value that never matches a real name, forces the next call through
+        static constexpr GLuint unknown = ~0u;
+
+        GLuint program;
+        GLuint vertexArray;
+        GLuint arrayBuffer;
+        GLuint uniformBuffer;
+        GLuint pixelUnpackBuffer;
+        GLuint uniformBindings[maxUniformBindings];
+
+        unsigned int activeUnit;
+        GLenum textureTargets[maxTextureUnits];
+        GLuint textures[maxTextureUnits];
+        GLuint samplers[maxTextureUnits];
+
+        int blend;      // -1 = unknown
+        GLenum blendSrc, blendDst;
+        int depthTest;
+        GLenum depthFunc;
+        int depthMask;
+        int viewport[4];
+
+        Stats stats;
+
+        void setActiveUnit(unsigned int unit);
+        bool filter(bool redundant)
+        {
+            redundant ? stats.skipped++ : stats.issued++;
+            return redundant;
+        }
+    };
+
+    // Set by the renderer that owns the cache for the current context
+    inline OpenGLStateCache* glState = nullptr;
+
+    // Routed through glState when a renderer is alive, straight to GL otherwise
+    namespace gl
+    {
+        inline void useProgram(GLuint program) { glState ? glState->useProgram(program) : glUseProgram(program); }
+        inline void bindVertexArray(GLuint vao) { glState ? glState->bindVertexArray(vao) : glBindVertexArray(vao); }
+        inline void bindBuffer(GLenum target, GLuint buffer) { glState ? glState->bindBuffer(target, buffer) : glBindBuffer(target, buffer); }
+        inline void bindBufferBase(GLenum target, GLuint index, GLuint buffer) { glState ? glState->bindBufferBase(target, index, buffer) : glBindBufferBase(target, index, buffer); }
+
+        inline void bindTexture(unsigned int unit, GLenum target, GLuint texture)
+        {
+            if (glState)
+            {
+                glState->bindTexture(unit, target, texture);
+                return;
+            }
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(target, texture);
+        }
+
+        inline void deleteProgram(GLuint program)
+        {
+            if (glState) glState->onProgramDeleted(program);
+            glDeleteProgram(program);
+        }
+
+        inline void deleteVertexArray(GLuint vao)
+        {
+            if (glState) glState->onVertexArrayDeleted(vao);
+            glDeleteVertexArrays(1, &vao);
+        }
+
+        inline void deleteBuffer(GLuint buffer)
+        {
+            if (glState) glState->onBufferDeleted(buffer);
+            glDeleteBuffers(1, &buffer);
+        }
+
+        inline void deleteTexture(GLuint texture)
+        {
+            if (glState) glState->onTextureDeleted(texture);
+            glDeleteTextures(1, &texture);
+        }
+    }
+}
@@ -0,0 +1,273 @@
+#include "openglstreambuffer.h"
+#include "openglextensions.h"
+#include "openglstate.h"
+#include "config.h"
+
+#include <algorithm>
+
+namespace
+{
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+kern::OpenGLStreamBuffer::OpenGLStreamBuffer(size_t frameCapacity)
+{
+    create(frameCapacity);
+}
+
+kern::OpenGLStreamBuffer::~OpenGLStreamBuffer()
+{
+    destroy();
+
+    for (auto& old : retired)
+    {
+        gl::deleteBuffer(old.buffer);
+    }
+    retired.clear();
+}
+
+void kern::OpenGLStreamBuffer::create(size_t frameCapacity)
+{
+    regionSize = frameCapacity;
+    region = 0;
+    head = 0;
+
+    const size_t totalSize = regionSize * framesInFlight;
+
+    if (glExtensions.bufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glExtensions.glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags);
+        persistentPtr = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        generation++;
+
+        if (persistentPtr)
+        {
+            cast("Stream buffer: " + std::to_string(totalSize / 1024) + " KB, persistently mapped");
+            return;
+        }
+
+        cast("Persistent mapping failed, falling back to orphaning", DebugLevel::Warning);
+        gl::deleteBuffer(buffer);
+        buffer = 0;
+    }
+
+    if (!buffer)
+    {
+        glGenBuffers(1, &buffer);
+    }
+
+    // Respecifying an existing buffer orphans its old storage, so in-flight
+    // draws keep reading the old data and the name survives. Data streamed
+    // but not yet drawn is gone though, hence the new generation.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    generation++;
+
+    cast("Stream buffer: " + std::to_string(totalSize / 1024) + " KB, orphaning");
+}
+
+void kern::OpenGLStreamBuffer::destroy()
+{
+    unmap();
+
+    for (auto& fence : fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (buffer)
+    {
+        if (persistentPtr)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            persistentPtr = nullptr;
+        }
+        gl::deleteBuffer(buffer);
+        buffer = 0;
+    }
+}
+
+kern::OpenGLStreamBuffer::Allocation kern::OpenGLStreamBuffer::allocate(size_t size, size_t alignment)
+{
+    if (size == 0 || !buffer)
+    {
+        return {};
+    }
+    alignment = std::max<size_t>(alignment, 1);
+
+    // Only one range can be mapped at a time without persistent mapping
+    unmap();
+
+    size_t base = region * regionSize;
+    size_t offset = alignUp(base + head, alignment);
+
+    if (offset + size > base + regionSize)
+    {
+        // This frame outgrew its region. Grow with headroom rather than stall
+        size_t needed = (offset - base) + size + alignment;
+        size_t newCapacity = std::max(regionSize * 2, needed * 2);
+        cast("Stream buffer region full, growing to " + std::to_string(newCapacity / 1024) + " KB", DebugLevel::Everything);
+
+        for (auto& fence : fences)
+        {
+            if (fence)
+            {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        if (persistentPtr)
+        {
+            // Spans handed out earlier this frame stay valid in the old buffer
+            retired.push_back({ buffer, framesInFlight });
+            buffer = 0;
+            persistentPtr = nullptr;
+        }
+
+        create(newCapacity);
+
+        base = 0;
+        offset = 0;
+    }
+
+    head = offset + size - base;
+
+    Allocation allocation;
+    allocation.offset = offset;
+    allocation.size = size;
+
+    if (persistentPtr)
+    {
+        allocation.data = persistentPtr + offset;
+        return allocation;
+    }
+
+    // The region's fence already guarantees the GPU is done with this range
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    mappedPtr = static_cast<uint8_t*>(glMapBufferRange(
+        GL_COPY_WRITE_BUFFER, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!mappedPtr)
+    {
+        cast("Failed to map stream buffer range", DebugLevel::Error);
+        return {};
+    }
+
+    mappedOffset = offset;
+    mappedSize = size;
+    allocation.data = mappedPtr;
+    return allocation;
+}
+
+void kern::OpenGLStreamBuffer::unmap()
+{
+    if (!mappedPtr)
+    {
+        return;
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    mappedPtr = nullptr;
+    mappedOffset = 0;
+    mappedSize = 0;
+}
+
+bool kern::OpenGLStreamBuffer::owns(const void* data, size_t size) const
+{
+    auto ptr = static_cast<const uint8_t*>(data);
+
+    if (persistentPtr)
+    {
+        return ptr >= persistentPtr && ptr + size <= persistentPtr + regionSize * framesInFlight;
+    }
+    return mappedPtr && ptr >= mappedPtr && ptr + size <= mappedPtr + mappedSize;
+}
+
+size_t kern::OpenGLStreamBuffer::offsetOf(const void* data) const
+{
+    auto ptr = static_cast<const uint8_t*>(data);
+
+    if (persistentPtr)
+    {
+        return static_cast<size_t>(ptr - persistentPtr);
+    }
+    return mappedOffset + static_cast<size_t>(ptr - mappedPtr);
+}
+
+void kern::OpenGLStreamBuffer::endFrame()
+{
+    unmap();
+
+    if (fences[region])
+    {
+        glDeleteSync(fences[region]);
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    region = (region + 1) % framesInFlight;
+    head = 0;
+    waitForRegion(region);
+
+    for (auto it = retired.begin(); it != retired.end();)
+    {
+        if (--it->framesLeft <= 0)
+        {
+            // Deleting a mapped buffer unmaps it implicitly
+            gl::deleteBuffer(it->buffer);
+            it = retired.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void kern::OpenGLStreamBuffer::waitForRegion(int index)
+{
+    GLsync fence = fences[index];
+    if (!fence)
+    {
+        return;
+    }
+
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true)
+    {
+        GLenum result = glClientWaitSync(fence, flags, 1000000000); // 1s
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            cast("glClientWaitSync failed on stream buffer fence", DebugLevel::Error);
+            break;
+        }
+        flags = 0;
+    }
+
+    glDeleteSync(fence);
+    fences[index] = nullptr;
+}
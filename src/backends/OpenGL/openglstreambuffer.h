@@ -0,0 +1,83 @@
+// src/backends/OpenGL/openglstreambuffer.h
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kern
+{
+    // Ring buffer for per-frame vertex data. The buffer is split into one
+    // region per frame in flight; a region is only rewritten once the fence
+    // placed at the end of its frame has signaled. With ARB_buffer_storage
+    // the whole buffer stays persistently mapped, otherwise every allocation
+    // maps its own range unsynchronized and the storage is orphaned on growth.
+    class OpenGLStreamBuffer
+    {
+    public:
+        static constexpr int framesInFlight = 3;
+
+        struct Allocation
+        {
+            void* data = nullptr;
+            size_t offset = 0;  // Byte offset into getBuffer()
+            size_t size = 0;
+        };
+
+        explicit OpenGLStreamBuffer(size_t frameCapacity = 4 * 1024 * 1024);
+        ~OpenGLStreamBuffer();
+
+        OpenGLStreamBuffer(const OpenGLStreamBuffer&) = delete;
+        OpenGLStreamBuffer& operator=(const OpenGLStreamBuffer&) = delete;
+
+        // Offset is a multiple of alignment, so vertex data can be drawn with
+        // first = offset / stride. Memory stays writable until unmap(), the
+        // next allocate() on the non-persistent path, or endFrame().
+        Allocation allocate(size_t size, size_t alignment);
+
+        // Makes pending writes visible to GL; call before drawing
+        void unmap();
+
+        // True if [data, data + size) lies inside the current writable mapping
+        bool owns(const void* data, size_t size) const;
+        size_t offsetOf(const void* data) const;
+
+        // Fences the current region and moves on to the next one
+        void endFrame();
+
+        GLuint getBuffer() const { return buffer; }
+        // Bumped whenever the storage is replaced: VAOs must re-point then, and
+        // offsets allocated before no longer hold their data
+        uint32_t getGeneration() const { return generation; }
+        bool isPersistent() const { return persistentPtr != nullptr; }
+
+    private:
+        GLuint buffer = 0;
+        uint32_t generation = 0;
+        size_t regionSize = 0;
+        int region = 0;
+        size_t head = 0;  // Bytes used in the current region
+
+        GLsync fences[framesInFlight] = {};
+
+        uint8_t* persistentPtr = nullptr;
+
+        // Buffers replaced by a bigger one stay mapped until every frame
+        // that could still reference them has retired
+        struct RetiredBuffer
+        {
+            GLuint buffer;
+            int framesLeft;
+        };
+        std::vector<RetiredBuffer> retired;
+
+        uint8_t* mappedPtr = nullptr;
+        size_t mappedOffset = 0;
+        size_t mappedSize = 0;
+
+        void create(size_t frameCapacity);
+        void destroy();
+        void waitForRegion(int index);
+    };
+}
@@ -0,0 +1,727 @@
+#include "softwarerenderer.h"
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KERN_SOFTWARE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Four horizontally adjacent pixels. Comparisons return masks with all
+    // bits of a lane set, the way SSE does.
+    struct Lanes
+    {
+#if KERN_SOFTWARE_SSE
+        __m128 v;
+
+        Lanes(__m128 v) : v(v) {}
+        explicit Lanes(float s) : v(_mm_set1_ps(s)) {}
+
+        static Lanes load(const float* p) { return _mm_loadu_ps(p); }
+        static Lanes ramp(float s) { return _mm_setr_ps(s, s + 1.0f, s + 2.0f, s + 3.0f); }
+        static Lanes mask(bool set) { return _mm_castsi128_ps(_mm_set1_epi32(set ? -1 : 0)); }
+        void store(float* p) const { _mm_storeu_ps(p, v); }
+        // One bit per lane
+        int bits() const { return _mm_movemask_ps(v); }
+
+        friend Lanes operator+(Lanes a, Lanes b) { return _mm_add_ps(a.v, b.v); }
+        friend Lanes operator-(Lanes a, Lanes b) { return _mm_sub_ps(a.v, b.v); }
+        friend Lanes operator*(Lanes a, Lanes b) { return _mm_mul_ps(a.v, b.v); }
+        friend Lanes operator/(Lanes a, Lanes b) { return _mm_div_ps(a.v, b.v); }
+        friend Lanes operator>(Lanes a, Lanes b) { return _mm_cmpgt_ps(a.v, b.v); }
+        friend Lanes operator<(Lanes a, Lanes b) { return _mm_cmplt_ps(a.v, b.v); }
+        friend Lanes operator==(Lanes a, Lanes b) { return _mm_cmpeq_ps(a.v, b.v); }
+        friend Lanes operator&(Lanes a, Lanes b) { return _mm_and_ps(a.v, b.v); }
+        friend Lanes operator|(Lanes a, Lanes b) { return _mm_or_ps(a.v, b.v); }
+
+        static Lanes select(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+        static Lanes clamp01(Lanes a) { return _mm_min_ps(_mm_max_ps(a.v, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+#else
+        float v[4];
+
+        Lanes() = default;
+        explicit Lanes(float s) : v{ s, s, s, s } {}
+
+        static Lanes load(const float* p)
+        {
+            Lanes r;
+            std::memcpy(r.v, p, sizeof(r.v));
+            return r;
+        }
+        static Lanes ramp(float s) { return from([&](int i) { return s + float(i); }); }
+        static Lanes mask(bool set) { return from([&](int) { return fromBits(set ? ~0u : 0u); }); }
+        void store(float* p) const { std::memcpy(p, v, sizeof(v)); }
+        int bits() const
+        {
+            int result = 0;
+            for (int i = 0; i < 4; i++) result |= int(toBits(v[i]) >> 31) << i;
+            return result;
+        }
+
+        friend Lanes operator+(Lanes a, Lanes b) { return from([&](int i) { return a.v[i] + b.v[i]; }); }
+        friend Lanes operator-(Lanes a, Lanes b) { return from([&](int i) { return a.v[i] - b.v[i]; }); }
+        friend Lanes operator*(Lanes a, Lanes b) { return from([&](int i) { return a.v[i] * b.v[i]; }); }
+        friend Lanes operator/(Lanes a, Lanes b) { return from([&](int i) { return a.v[i] / b.v[i]; }); }
+        friend Lanes operator>(Lanes a, Lanes b) { return from([&](int i) { return fromBits(a.v[i] > b.v[i] ? ~0u : 0u); }); }
+        friend Lanes operator<(Lanes a, Lanes b) { return from([&](int i) { return fromBits(a.v[i] < b.v[i] ? ~0u : 0u); }); }
+        friend Lanes operator==(Lanes a, Lanes b) { return from([&](int i) { return fromBits(a.v[i] == b.v[i] ? ~0u : 0u); }); }
+        friend Lanes operator&(Lanes a, Lanes b) { return from([&](int i) { return fromBits(toBits(a.v[i]) & toBits(b.v[i])); }); }
+        friend Lanes operator|(Lanes a, Lanes b) { return from([&](int i) { return fromBits(toBits(a.v[i]) | toBits(b.v[i])); }); }
+
+        static Lanes select(Lanes mask, Lanes a, Lanes b) { return from([&](int i) { return toBits(mask.v[i]) ? a.v[i] : b.v[i]; }); }
+        static Lanes clamp01(Lanes a) { return from([&](int i) { return std::clamp(a.v[i], 0.0f, 1.0f); }); }
+
+        template<typename F>
+        static Lanes from(F f)
+        {
+            Lanes r;
+            for (int i = 0; i < 4; i++) r.v[i] = f(i);
+            return r;
+        }
+        static uint32_t toBits(float f)
+        {
+            uint32_t u;
+            std::memcpy(&u, &f, sizeof(u));
+            return u;
+        }
+        static float fromBits(uint32_t u)
+        {
+            float f;
+            std::memcpy(&f, &u, sizeof(f));
+            return f;
+        }
+#endif
+    };
+
+    uint32_t packColor(float r, float g, float b, float a)
+    {
+        auto byte = [](float c) { return uint32_t(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f); };
+        return byte(r) | byte(g) << 8 | byte(b) << 16 | byte(a) << 24;
+    }
+
+    // Writes the masked lanes of four RGBA colors to dst[0..3]
+    void storeColors(uint32_t* dst, Lanes r, Lanes g, Lanes b, Lanes a, Lanes mask)
+    {
+#if KERN_SOFTWARE_SSE
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        auto bytes = [&](Lanes c) { return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Lanes::clamp01(c).v, scale), half)); };
+
+        const __m128i packed = _mm_or_si128(
+            _mm_or_si128(bytes(r), _mm_slli_epi32(bytes(g), 8)),
+            _mm_or_si128(_mm_slli_epi32(bytes(b), 16), _mm_slli_epi32(bytes(a), 24)));
+        const __m128i keep = _mm_castps_si128(mask.v);
+        const __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(_mm_and_si128(keep, packed), _mm_andnot_si128(keep, old)));
+#else
+        const int bits = mask.bits();
+        for (int i = 0; i < 4; i++)
+        {
+            if (bits & (1 << i)) dst[i] = packColor(r.v[i], g.v[i], b.v[i], a.v[i]);
+        }
+#endif
+    }
+
+    // Same for one color in every lane
+    void storeColor(uint32_t* dst, uint32_t color, Lanes mask)
+    {
+#if KERN_SOFTWARE_SSE
+        const __m128i keep = _mm_castps_si128(mask.v);
+        const __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+        const __m128i packed = _mm_set1_epi32(int(color));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(_mm_and_si128(keep, packed), _mm_andnot_si128(keep, old)));
+#else
+        const int bits = mask.bits();
+        for (int i = 0; i < 4; i++)
+        {
+            if (bits & (1 << i)) dst[i] = color;
+        }
+#endif
+    }
+
+    // Source-over blending, like GL_SRC_ALPHA / GL_ONE_MINUS_SRC_ALPHA
+    uint32_t blend(uint32_t dst, const kern::Color& color, float alpha)
+    {
+        auto channel = [&](float src, int shift) {
+            const float old = float((dst >> shift) & 0xFF) / 255.0f;
+            return src * alpha + old * (1.0f - alpha);
+        };
+        return packColor(channel(color.r, 0), channel(color.g, 8), channel(color.b, 16), channel(alpha, 24));
+    }
+
+    float roundedRectDistance(kern::Vector2 p, kern::Vector2 halfSize, float radius)
+    {
+        radius = std::min(radius, std::min(halfSize.x, halfSize.y));
+        const float qx = std::abs(p.x) - halfSize.x + radius;
+        const float qy = std::abs(p.y) - halfSize.y + radius;
+        const float outside = std::sqrt(std::max(qx, 0.0f) * std::max(qx, 0.0f) + std::max(qy, 0.0f) * std::max(qy, 0.0f));
+        return outside + std::min(std::max(qx, qy), 0.0f) - radius;
+    }
+
+    float ellipseDistance(kern::Vector2 p, kern::Vector2 radii)
+    {
+        const float ex = p.x / radii.x, ey = p.y / radii.y;
+        const float k0 = std::sqrt(ex * ex + ey * ey);
+        const float k1 = std::sqrt((ex / radii.x) * (ex / radii.x) + (ey / radii.y) * (ey / radii.y));
+        return k1 > 0.0f ? k0 * (k0 - 1.0f) / k1 : -std::min(radii.x, radii.y);
+    }
+
+    struct EdgeSetup
+    {
+        float a[3], b[3], c[3];  // Edge i is opposite vertex i: a * x + b * y + c
+        float area;
+    };
+
+    EdgeSetup setupEdges(const float* x, const float* y)
+    {
+        EdgeSetup edges;
+        for (int i = 0; i < 3; i++)
+        {
+            const int from = (i + 1) % 3;
+            const int to = (i + 2) % 3;
+            edges.a[i] = y[from] - y[to];
+            edges.b[i] = x[to] - x[from];
+            edges.c[i] = -(edges.a[i] * x[from] + edges.b[i] * y[from]);
+        }
+        edges.area = edges.a[0] * x[0] + edges.b[0] * y[0] + edges.c[0];
+        return edges;
+    }
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, unsigned int threadCount)
+    : width(0), height(0), stride(0), pool(threadCount)
+{
+    resize(width, height);
+    cast("Software renderer: " + std::to_string(pool.getThreadCount() + 1) + " threads, " +
+#if KERN_SOFTWARE_SSE
+        "SSE"
+#else
+        "scalar"
+#endif
+    );
+}
+
+void SoftwareRenderer::resize(int w, int h)
+{
+    flush();
+
+    width = std::max(w, 1);
+    height = std::max(h, 1);
+    stride = (width + 3) & ~3;
+    tilesX = (width + tileSize - 1) / tileSize;
+    tilesY = (height + tileSize - 1) / tileSize;
+
+    colorBuffer.assign(size_t(stride) * height, clearColor);
+    depthBuffer.assign(size_t(stride) * height, 1.0f);
+    bins.assign(size_t(tilesX) * tilesY, {});
+}
+
+void SoftwareRenderer::setClearColor(float r, float g, float b, float a)
+{
+    clearColor = packColor(r, g, b, a);
+}
+
+void SoftwareRenderer::clear()
+{
+    // Draws made before the clear still have to land in the old image
+    flush();
+    std::fill(colorBuffer.begin(), colorBuffer.end(), clearColor);
+    std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+}
+
+void SoftwareRenderer::present()
+{
+    flush();
+    lastFrameStats = frameStats;
+    frameStats = {};
+}
+
+void SoftwareRenderer::setCamera(const kern::Mat4& view, const kern::Mat4& projection)
+{
+    viewProjection = projection * view;
+}
+
+std::vector<uint8_t> SoftwareRenderer::readPixels() const
+{
+    const size_t rowSize = size_t(width) * 4;
+    std::vector<uint8_t> pixels(rowSize * height);
+    for (int y = 0; y < height; y++)
+    {
+        std::memcpy(pixels.data() + y * rowSize, colorBuffer.data() + size_t(y) * stride, rowSize);
+    }
+    return pixels;
+}
+
+void SoftwareRenderer::renderTri(kern::Vector2 a, kern::Vector2 b, kern::Vector2 c, kern::Color color)
+{
+    // The built-in tri shader writes opaque colors at z = 0, untested
+    ClipVertex corners[3];
+    const kern::Vector2 points[3] = { a, b, c };
+    for (int i = 0; i < 3; i++)
+    {
+        corners[i] = { { points[i].x, points[i].y, 0.0f, 1.0f }, { color.r, color.g, color.b, 1.0f } };
+    }
+    const ClipVertex* vertices[3] = { &corners[0], &corners[1], &corners[2] };
+    pushTriangle(vertices, false);
+    frameStats.drawCalls++;
+}
+
+void SoftwareRenderer::renderLine(kern::Vector2 a, kern::Vector2 b, kern::Color color, float thickness)
+{
+    const kern::Vector2 points[] = { a, b };
+    renderPolyline(points, thickness, color, {});
+}
+
+void SoftwareRenderer::renderPolyline(std::span<const kern::Vector2> points, float thickness, kern::Color color, const kern::PolylineStyle& style)
+{
+    polylineTriangles.clear();
+    kern::expandPolyline(points, thickness, style, kern::Vector2(width * 0.5f, height * 0.5f), polylineTriangles);
+
+    ClipVertex corners[3];
+    const ClipVertex* vertices[3] = { &corners[0], &corners[1], &corners[2] };
+    for (size_t i = 0; i + 2 < polylineTriangles.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            const kern::Vector2& p = polylineTriangles[i + k];
+            corners[k] = { { p.x, p.y, 0.0f, 1.0f }, { color.r, color.g, color.b, 1.0f } };
+        }
+        pushTriangle(vertices, false);
+    }
+    frameStats.drawCalls++;
+}
+
+void SoftwareRenderer::renderCircle(kern::Vector2 center, float radius, kern::Color color)
+{
+    renderEllipse(center, kern::Vector2(radius, radius), 0.0f, color);
+}
+
+void SoftwareRenderer::renderRect(kern::Vector2 position, kern::Vector2 size, float cornerRadius, kern::Color color)
+{
+    const kern::Vector2 halfSize(std::abs(size.x) * 0.5f, std::abs(size.y) * 0.5f);
+    pushShape({ position + size * 0.5f, halfSize, color, std::max(cornerRadius, 0.0f), ShapeType::Rect, 0, 0, 0, 0 });
+    frameStats.drawCalls++;
+}
+
+void SoftwareRenderer::renderEllipse(kern::Vector2 center, kern::Vector2 radii, float thickness, kern::Color color)
+{
+    const kern::Vector2 halfSize(std::abs(radii.x), std::abs(radii.y));
+    pushShape({ center, halfSize, color, std::max(thickness, 0.0f), ShapeType::Ellipse, 0, 0, 0, 0 });
+    frameStats.drawCalls++;
+}
+
+void SoftwareRenderer::pushShape(const Shape& shape)
+{
+    if (!(shape.halfSize.x > 0.0f && shape.halfSize.y > 0.0f)) return;
+
+    // Two pixels of margin for the anti-aliased edge, as in shape.vert
+    const float marginX = 4.0f / width;
+    const float marginY = 4.0f / height;
+    const float left = (shape.center.x - shape.halfSize.x - marginX + 1.0f) * 0.5f * width;
+    const float right = (shape.center.x + shape.halfSize.x + marginX + 1.0f) * 0.5f * width;
+    const float top = (1.0f - shape.center.y - shape.halfSize.y - marginY) * 0.5f * height;
+    const float bottom = (1.0f - shape.center.y + shape.halfSize.y + marginY) * 0.5f * height;
+
+    Shape bounded = shape;
+    bounded.minX = int(std::floor(std::clamp(left, 0.0f, float(width))));
+    bounded.maxX = int(std::ceil(std::clamp(right, 0.0f, float(width))));
+    bounded.minY = int(std::floor(std::clamp(top, 0.0f, float(height))));
+    bounded.maxY = int(std::ceil(std::clamp(bottom, 0.0f, float(height))));
+    if (bounded.minX >= bounded.maxX || bounded.minY >= bounded.maxY) return;
+
+    shapes.push_back(bounded);
+    order.push_back(uint32_t(shapes.size() - 1) | shapeBit);
+    pendingAdded();
+}
+
+void SoftwareRenderer::drawVertices(const void* vertices, size_t vertexCount, size_t vertexStride, const uint32_t* indices, size_t indexCount, const kern::VertexLayout& layout, const kern::Mat4& model)
+{
+    const std::vector<kern::VertexElement>& elements = layout.getElements();
+    if (!vertices || elements.empty() || elements[0].isPerInstance())
+    {
+        cast("Software draw needs a vertex layout starting with the position", kern::DebugLevel::Error);
+        return;
+    }
+
+    const kern::VertexElement& position = elements[0];
+    const size_t positionSize = position.getTypeComponentCount();
+    if (position.type == kern::VertexElementType::Mat4 || positionSize < 2)
+    {
+        cast("Software draw: position must be a Vector2 or Vector3", kern::DebugLevel::Error);
+        return;
+    }
+
+    const kern::VertexElement* color = nullptr;
+    if (elements.size() > 1 && !elements[1].isPerInstance() &&
+        (elements[1].type == kern::VertexElementType::Float3 || elements[1].type == kern::VertexElementType::Float4))
+    {
+        color = &elements[1];
+    }
+
+    // Every vertex is transformed once, however many triangles share it
+    const kern::Mat4 transform = viewProjection * model;
+    const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+    clipVertices.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const uint8_t* vertex = bytes + i * vertexStride;
+
+        float p[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        std::memcpy(p, vertex + position.offset, std::min<size_t>(positionSize, 4) * sizeof(float));
+        clipVertices[i].position = transform * kern::Mat4::col_type(p[0], p[1], p[2], p[3]);
+
+        float* c = clipVertices[i].color;
+        c[0] = c[1] = c[2] = c[3] = 1.0f;
+        if (color) std::memcpy(c, vertex + color->offset, color->getTypeComponentCount() * sizeof(float));
+    }
+
+    const size_t count = indices ? indexCount : vertexCount;
+    for (size_t i = 0; i + 2 < count; i += 3)
+    {
+        const size_t a = indices ? indices[i] : i;
+        const size_t b = indices ? indices[i + 1] : i + 1;
+        const size_t c = indices ? indices[i + 2] : i + 2;
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount) continue;
+
+        clipTriangle(clipVertices[a], clipVertices[b], clipVertices[c]);
+    }
+    frameStats.drawCalls++;
+}
+
+void SoftwareRenderer::clipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c)
+{
+    const ClipVertex* input[3] = { &a, &b, &c };
+
+    // Entirely outside one side of the view volume
+    for (int axis = 0; axis < 3; axis++)
+    {
+        bool allBelow = true, allAbove = true;
+        for (const ClipVertex* v : input)
+        {
+            allBelow = allBelow && v->position[axis] < -v->position.w;
+            allAbove = allAbove && v->position[axis] > v->position.w;
+        }
+        if (allBelow || allAbove) return;
+    }
+
+    // Only the near plane (z >= -w) is clipped for real; the other sides
+    // are handled by the bounds and the depth test
+    auto distance = [](const ClipVertex& v) { return v.position.z + v.position.w; };
+    if (distance(a) >= 0.0f && distance(b) >= 0.0f && distance(c) >= 0.0f)
+    {
+        pushTriangle(input, true);
+        return;
+    }
+
+    ClipVertex polygon[4];
+    int count = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const ClipVertex& from = *input[i];
+        const ClipVertex& to = *input[(i + 1) % 3];
+        const float d0 = distance(from);
+        const float d1 = distance(to);
+
+        if (d0 >= 0.0f) polygon[count++] = from;
+        if ((d0 >= 0.0f) != (d1 >= 0.0f))
+        {
+            const float t = d0 / (d0 - d1);
+            ClipVertex& v = polygon[count++];
+            v.position = from.position + (to.position - from.position) * t;
+            for (int k = 0; k < 4; k++) v.color[k] = from.color[k] + (to.color[k] - from.color[k]) * t;
+        }
+    }
+
+    for (int i = 1; i + 1 < count; i++)
+    {
+        const ClipVertex* fan[3] = { &polygon[0], &polygon[i], &polygon[i + 1] };
+        pushTriangle(fan, true);
+    }
+}
+
+void SoftwareRenderer::pushTriangle(const ClipVertex* vertices[3], bool depthTest)
+{
+    Triangle triangle;
+    triangle.depthTest = depthTest;
+
+    for (int i = 0; i < 3; i++)
+    {
+        const kern::Mat4::col_type& p = vertices[i]->position;
+        const float invW = 1.0f / p.w;
+        triangle.x[i] = (p.x * invW * 0.5f + 0.5f) * width;
+        triangle.y[i] = (0.5f - p.y * invW * 0.5f) * height;  // Top row first
+        triangle.z[i] = p.z * invW * 0.5f + 0.5f;
+        triangle.invW[i] = invW;
+        for (int k = 0; k < 4; k++) triangle.color[i][k] = vertices[i]->color[k] * invW;
+    }
+
+    // Both windings are drawn; make the covered side the positive one
+    const EdgeSetup edges = setupEdges(triangle.x, triangle.y);
+    if (edges.area < 0.0f)
+    {
+        std::swap(triangle.x[1], triangle.x[2]);
+        std::swap(triangle.y[1], triangle.y[2]);
+        std::swap(triangle.z[1], triangle.z[2]);
+        std::swap(triangle.invW[1], triangle.invW[2]);
+        std::swap(triangle.color[1], triangle.color[2]);
+    }
+    else if (!(edges.area > 0.0f))
+    {
+        return;  // Degenerate, or NaN from a vertex at w = 0
+    }
+
+    const auto [minX, maxX] = std::minmax({ triangle.x[0], triangle.x[1], triangle.x[2] });
+    const auto [minY, maxY] = std::minmax({ triangle.y[0], triangle.y[1], triangle.y[2] });
+    triangle.minX = int(std::floor(std::clamp(minX, 0.0f, float(width))));
+    triangle.maxX = int(std::ceil(std::clamp(maxX, 0.0f, float(width))));
+    triangle.minY = int(std::floor(std::clamp(minY, 0.0f, float(height))));
+    triangle.maxY = int(std::ceil(std::clamp(maxY, 0.0f, float(height))));
+    if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY) return;
+
+    triangles.push_back(triangle);
+    order.push_back(uint32_t(triangles.size() - 1));
+    pendingAdded();
+}
+
+void SoftwareRenderer::pendingAdded()
+{
+    if (order.size() >= maxPendingPrimitives) flush();
+}
+
+void SoftwareRenderer::flush()
+{
+    if (order.empty()) return;
+
+    for (std::vector<uint32_t>& bin : bins) bin.clear();
+
+    for (uint32_t entry : order)
+    {
+        int minX, minY, maxX, maxY;
+        if (entry & shapeBit)
+        {
+            const Shape& shape = shapes[entry & ~shapeBit];
+            minX = shape.minX, minY = shape.minY, maxX = shape.maxX, maxY = shape.maxY;
+        }
+        else
+        {
+            const Triangle& triangle = triangles[entry];
+            minX = triangle.minX, minY = triangle.minY, maxX = triangle.maxX, maxY = triangle.maxY;
+        }
+
+        const EdgeSetup edges = (entry & shapeBit) ? EdgeSetup{} : setupEdges(triangles[entry].x, triangles[entry].y);
+
+        for (int ty = minY / tileSize; ty <= (maxY - 1) / tileSize; ty++)
+        {
+            for (int tx = minX / tileSize; tx <= (maxX - 1) / tileSize; tx++)
+            {
+                if (!(entry & shapeBit))
+                {
+                    // Skipped when the tile lies wholly outside one edge,
+                    // tested at the corner pixel furthest along its normal
+                    bool outside = false;
+                    for (int i = 0; i < 3 && !outside; i++)
+                    {
+                        const float cx = (edges.a[i] > 0.0f ? (tx + 1) * tileSize - 1 : tx * tileSize) + 0.5f;
+                        const float cy = (edges.b[i] > 0.0f ? (ty + 1) * tileSize - 1 : ty * tileSize) + 0.5f;
+                        outside = edges.a[i] * cx + edges.b[i] * cy + edges.c[i] < 0.0f;
+                    }
+                    if (outside) continue;
+                }
+                bins[size_t(ty) * tilesX + tx].push_back(entry);
+            }
+        }
+    }
+
+    // Tiles are claimed from a counter by the pool's workers and this thread
+    const int tileCount = tilesX * tilesY;
+    std::atomic<int> next{ 0 };
+    auto work = [&]()
+    {
+        for (int tile = next++; tile < tileCount; tile = next++)
+        {
+            renderTile(tile % tilesX, tile / tilesX);
+        }
+    };
+
+    const size_t helpers = std::min(pool.getThreadCount(), size_t(tileCount - 1));
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t remaining = helpers;
+    for (size_t i = 0; i < helpers; i++)
+    {
+        pool.submit([&]()
+        {
+            work();
+            // Notified under the lock, so the waiter can't return and
+            // destroy `finished` before this is done with it
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) finished.notify_one();
+        });
+    }
+    work();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]() { return remaining == 0; });
+    }
+
+    triangles.clear();
+    shapes.clear();
+    order.clear();
+}
+
+void SoftwareRenderer::renderTile(int tileX, int tileY)
+{
+    const int x0 = tileX * tileSize;
+    const int y0 = tileY * tileSize;
+    const int x1 = std::min(x0 + tileSize, width);
+    const int y1 = std::min(y0 + tileSize, height);
+
+    for (uint32_t entry : bins[size_t(tileY) * tilesX + tileX])
+    {
+        if (entry & shapeBit)
+        {
+            const Shape& shape = shapes[entry & ~shapeBit];
+            rasterizeShape(shape, std::max(x0, shape.minX), std::max(y0, shape.minY), std::min(x1, shape.maxX), std::min(y1, shape.maxY));
+        }
+        else
+        {
+            const Triangle& triangle = triangles[entry];
+            rasterizeTriangle(triangle, std::max(x0, triangle.minX), std::max(y0, triangle.minY), std::min(x1, triangle.maxX), std::min(y1, triangle.maxY));
+        }
+    }
+}
+
+void SoftwareRenderer::rasterizeTriangle(const Triangle& t, int x0, int y0, int x1, int y1)
+{
+    const EdgeSetup edges = setupEdges(t.x, t.y);
+    const Lanes invArea(1.0f / edges.area);
+
+    // Top-left rule: a pixel center exactly on an edge belongs to the
+    // triangle only if that edge is a top or left one, so shared edges
+    // are drawn once
+    Lanes a[3] = { Lanes(edges.a[0]), Lanes(edges.a[1]), Lanes(edges.a[2]) };
+    Lanes topLeft[3] = { Lanes::mask(false), Lanes::mask(false), Lanes::mask(false) };
+    for (int i = 0; i < 3; i++)
+    {
+        topLeft[i] = Lanes::mask(edges.a[i] > 0.0f || (edges.a[i] == 0.0f && edges.b[i] > 0.0f));
+    }
+
+    // Attributes as value at vertex 0 plus weighted deltas to 1 and 2
+    auto interpolate = [&](float v0, float v1, float v2, Lanes l1, Lanes l2) {
+        return Lanes(v0) + l1 * Lanes(v1 - v0) + l2 * Lanes(v2 - v0);
+    };
+
+    // Solid colors, as from every 2D draw, skip interpolation altogether
+    const bool flat = std::equal(&t.color[0][0], &t.color[0][0] + 4, &t.color[1][0]) &&
+                      std::equal(&t.color[0][0], &t.color[0][0] + 4, &t.color[2][0]);
+    const uint32_t flatColor = packColor(t.color[0][0] / t.invW[0], t.color[0][1] / t.invW[0], t.color[0][2] / t.invW[0], t.color[0][3] / t.invW[0]);
+
+    const Lanes zero(0.0f);
+    // Groups of four start on multiples of four, like the row stride, so
+    // they never reach past the padded row
+    const int startX = x0 & ~3;
+
+    for (int y = y0; y < y1; y++)
+    {
+        const float py = y + 0.5f;
+        Lanes rowEdge[3] = { Lanes(edges.b[0] * py + edges.c[0]), Lanes(edges.b[1] * py + edges.c[1]), Lanes(edges.b[2] * py + edges.c[2]) };
+        float* depthRow = depthBuffer.data() + size_t(y) * stride;
+        uint32_t* colorRow = colorBuffer.data() + size_t(y) * stride;
+
+        for (int x = startX; x < x1; x += 4)
+        {
+            const Lanes px = Lanes::ramp(x + 0.5f);
+            const Lanes e0 = a[0] * px + rowEdge[0];
+            const Lanes e1 = a[1] * px + rowEdge[1];
+            const Lanes e2 = a[2] * px + rowEdge[2];
+
+            Lanes mask = ((e0 > zero) | ((e0 == zero) & topLeft[0])) &
+                         ((e1 > zero) | ((e1 == zero) & topLeft[1])) &
+                         ((e2 > zero) | ((e2 == zero) & topLeft[2]));
+            if (!mask.bits()) continue;
+
+            const Lanes l1 = e1 * invArea;
+            const Lanes l2 = e2 * invArea;
+
+            if (t.depthTest)
+            {
+                const Lanes z = interpolate(t.z[0], t.z[1], t.z[2], l1, l2);
+                const Lanes depth = Lanes::load(depthRow + x);
+                mask = mask & (z < depth);
+                if (!mask.bits()) continue;
+                Lanes::select(mask, z, depth).store(depthRow + x);
+            }
+
+            if (flat)
+            {
+                storeColor(colorRow + x, flatColor, mask);
+                continue;
+            }
+
+            const Lanes w = Lanes(1.0f) / interpolate(t.invW[0], t.invW[1], t.invW[2], l1, l2);
+            storeColors(colorRow + x,
+                interpolate(t.color[0][0], t.color[1][0], t.color[2][0], l1, l2) * w,
+                interpolate(t.color[0][1], t.color[1][1], t.color[2][1], l1, l2) * w,
+                interpolate(t.color[0][2], t.color[1][2], t.color[2][2], l1, l2) * w,
+                interpolate(t.color[0][3], t.color[1][3], t.color[2][3], l1, l2) * w,
+                mask);
+        }
+    }
+}
+
+void SoftwareRenderer::rasterizeShape(const Shape& shape, int x0, int y0, int x1, int y1)
+{
+    // One pixel in NDC
+    const float stepX = 2.0f / width;
+    const float stepY = 2.0f / height;
+
+    auto distance = [&](kern::Vector2 p)
+    {
+        if (shape.type == ShapeType::Rect) return roundedRectDistance(p, shape.halfSize, shape.size);
+
+        float d = ellipseDistance(p, shape.halfSize);
+        // Rings keep a band of the given thickness around the outline
+        if (shape.size > 0.0f) d = std::abs(d + shape.size * 0.5f) - shape.size * 0.5f;
+        return d;
+    };
+
+    // |gradient| stays well under 4 for both distances, so beyond this the
+    // one pixel ramp below is certainly all or nothing
+    const float certain = 2.0f * (stepX + stepY);
+    const uint32_t opaque = packColor(shape.color.r, shape.color.g, shape.color.b, 1.0f);
+
+    for (int y = y0; y < y1; y++)
+    {
+        const float localY = 1.0f - (y + 0.5f) * stepY - shape.center.y;
+        uint32_t* colorRow = colorBuffer.data() + size_t(y) * stride;
+
+        for (int x = x0; x < x1; x++)
+        {
+            const kern::Vector2 local((x + 0.5f) * stepX - 1.0f - shape.center.x, localY);
+
+            // Differences to the next pixel stand in for fwidth()
+            const float d = distance(local);
+            if (d > certain) continue;
+            if (d < -certain)
+            {
+                colorRow[x] = shape.color.a >= 1.0f ? opaque : blend(colorRow[x], shape.color, shape.color.a);
+                continue;
+            }
+
+            const float dx = distance(kern::Vector2(local.x + stepX, local.y)) - d;
+            const float dy = distance(kern::Vector2(local.x, local.y - stepY)) - d;
+            const float coverage = std::clamp(0.5f - d / std::max(std::abs(dx) + std::abs(dy), 1e-6f), 0.0f, 1.0f);
+            if (coverage <= 0.0f) continue;
+
+            colorRow[x] = blend(colorRow[x], shape.color, shape.color.a * coverage);
+        }
+    }
+}
@@ -0,0 +1,149 @@
+// src/backends/Software/softwarerenderer.h
+#pragma once
+
+#include "backends/renderer.h"
+#include "utils/vectors.h"
+#include "utils/colors.h"
+#include "utils/vertexlayout.h"
+#include "utils/threadpool.h"
+#include "kernmath.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Renders into a CPU framebuffer, no GPU or GL context involved. Draws are
+// collected until present() (or a clear), binned into screen tiles and
+// rasterized tile by tile on all cores; every tile runs its primitives in
+// submission order, so the image is the same whatever the thread count.
+// Shapes use the same NDC coordinates and look as the OpenGL renderer's.
+class SoftwareRenderer : public Renderer
+{
+public:
+    static constexpr int tileSize = 64;
+
+    // 0 threads uses all cores: the pool's workers plus the calling thread
+    SoftwareRenderer(int width, int height, unsigned int threadCount = 0);
+    ~SoftwareRenderer() override = default;
+
+    SoftwareRenderer(const SoftwareRenderer&) = delete;
+    SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+    void clear() override;
+    void present() override;
+    void setClearColor(float r, float g, float b, float a) override;
+    void renderTri(kern::Vector2 a, kern::Vector2 b, kern::Vector2 c, kern::Color color) override;
+    void renderLine(kern::Vector2 a, kern::Vector2 b, kern::Color color, float thickness) override;
+    void renderPolyline(std::span<const kern::Vector2> points, float thickness, kern::Color color, const kern::PolylineStyle& style) override;
+    void renderCircle(kern::Vector2 center, float radius, kern::Color color) override;
+    void renderRect(kern::Vector2 position, kern::Vector2 size, float cornerRadius, kern::Color color) override;
+    void renderEllipse(kern::Vector2 center, kern::Vector2 radii, float thickness, kern::Color color) override;
+    kern::RenderStats getStats() const override { return lastFrameStats; }
+
+    // Applied to every draw() from now on, like the KernFrame block
+    void setCamera(const kern::Mat4& view, const kern::Mat4& projection);
+
+    // Contents are lost; pending draws are rendered at the old size first
+    void resize(int width, int height);
+
+    // Triangle lists with a fixed pipeline standing in for the shader: the
+    // layout's first element is the position (Vector2/Vector3), transformed
+    // by projection * view * model, and a second Vector3/Color element, if
+    // any, is the color, interpolated perspective-correct. Depth tested.
+    template<typename Vertex>
+    void draw(std::span<const Vertex> vertices, const kern::VertexLayout& layout, const kern::Mat4& model = kern::Mat4(1.0f))
+    {
+        drawVertices(vertices.data(), vertices.size(), sizeof(Vertex), nullptr, 0, layout, model);
+    }
+
+    template<typename Vertex>
+    void draw(const std::vector<Vertex>& vertices, const kern::VertexLayout& layout, const kern::Mat4& model = kern::Mat4(1.0f))
+    {
+        draw(std::span<const Vertex>(vertices), layout, model);
+    }
+
+    template<typename Vertex>
+    void drawIndexed(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const kern::VertexLayout& layout, const kern::Mat4& model = kern::Mat4(1.0f))
+    {
+        drawVertices(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size(), layout, model);
+    }
+
+    // Last presented frame as tightly packed RGBA8, top row first
+    std::vector<uint8_t> readPixels() const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    // Screen-space triangle; attributes are divided by w for perspective
+    // correct interpolation, and multiplied back per pixel
+    struct Triangle
+    {
+        float x[3], y[3];
+        float z[3];           // Window depth, 0 near .. 1 far
+        float invW[3];
+        float color[3][4];    // Times invW
+        int minX, minY, maxX, maxY;  // Pixel bounds, max exclusive
+        bool depthTest;
+    };
+
+    // Matches the OpenGL shape shader: a signed distance in NDC
+    enum class ShapeType
+    {
+        Rect,     // Rounded when size > 0
+        Ellipse   // A ring when size > 0
+    };
+
+    struct Shape
+    {
+        kern::Vector2 center, halfSize;
+        kern::Color color;
+        float size;
+        ShapeType type;
+        int minX, minY, maxX, maxY;
+    };
+
+    // Rendered early past this many, bounding the memory of one frame
+    static constexpr size_t maxPendingPrimitives = 1 << 18;
+    // Set on bin entries that index shapes rather than triangles
+    static constexpr uint32_t shapeBit = 0x80000000u;
+
+    int width, height;
+    int stride;  // Pixels per row, padded to whole SIMD groups
+    int tilesX = 0, tilesY = 0;
+
+    std::vector<uint32_t> colorBuffer;  // RGBA8, top row first
+    std::vector<float> depthBuffer;
+    uint32_t clearColor = 0xFF000000u;
+
+    kern::Mat4 viewProjection = kern::Mat4(1.0f);
+
+    std::vector<Triangle> triangles;
+    std::vector<Shape> shapes;
+    std::vector<uint32_t> order;  // Indices into both, in submission order
+    std::vector<std::vector<uint32_t>> bins;  // Primitives per tile, in order
+    std::vector<kern::Vector2> polylineTriangles;
+
+    kern::ThreadPool pool;
+    kern::RenderStats frameStats;
+    kern::RenderStats lastFrameStats;
+
+    struct ClipVertex
+    {
+        kern::Mat4::col_type position;
+        float color[4];
+    };
+    std::vector<ClipVertex> clipVertices;
+
+    void drawVertices(const void* vertices, size_t vertexCount, size_t vertexStride, const uint32_t* indices, size_t indexCount, const kern::VertexLayout& layout, const kern::Mat4& model);
+    void clipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c);
+    void pushTriangle(const ClipVertex* vertices[3], bool depthTest);
+    void pushShape(const Shape& shape);
+    void pendingAdded();
+
+    // Bins and rasterizes everything pending
+    void flush();
+    void renderTile(int tileX, int tileY);
+    void rasterizeTriangle(const Triangle& triangle, int x0, int y0, int x1, int y1);
+    void rasterizeShape(const Shape& shape, int x0, int y0, int x1, int y1);
+};
@@ -2,6 +2,22 @@
 #pragma once
 #include "utils/vectors.h"
 #include "utils/colors.h"
+#include "utils/renderqueue.h"
+#include "utils/polyline.h"
+#include <cstdint>
+#include <span>
+
+namespace kern
+{
+    // Counters for the last presented frame
+    struct RenderStats
+    {
+        uint64_t drawCalls = 0;
+        uint64_t stateChanges = 0;           // State calls that reached the API
+        uint64_t redundantStateChanges = 0;  // Calls the state cache filtered out
+        RenderQueueStats queue;              // Commands submitted through submit()
+    };
+}
 
 class Renderer
 {
@@ -13,5 +29,11 @@ public:
     virtual void setClearColor(float r, float g, float b, float a) = 0;
     virtual void renderTri(kern::Vector2 a, kern::Vector2 b, kern::Vector2 c, kern::Color color) = 0;
     virtual void renderLine(kern::Vector2 a, kern::Vector2 b, kern::Color color, float thickness) = 0;
+    // Thickness is in pixels
+    virtual void renderPolyline(std::span<const kern::Vector2> points, float thickness, kern::Color color, const kern::PolylineStyle& style) = 0;
     virtual void renderCircle(kern::Vector2 center, float radius, kern::Color color) = 0;
+    virtual void renderRect(kern::Vector2 position, kern::Vector2 size, float cornerRadius, kern::Color color) = 0;
+    // Filled when thickness is 0, otherwise a ring of that thickness
+    virtual void renderEllipse(kern::Vector2 center, kern::Vector2 radii, float thickness, kern::Color color) = 0;
+    virtual kern::RenderStats getStats() const = 0;
 };
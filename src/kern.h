@@ -3,6 +3,21 @@
 #include "utils/vectors.h"
 #include "utils/colors.h"
 #include "utils/vertexlayout.h"
+#include "utils/mesh.h"
+#include "utils/meshoptimizer.h"
 #include "utils/textures.h"
+#include "utils/textureloader.h"
+#include "utils/resourcemanager.h"
+#include "utils/shaderlibrary.h"
+#include "utils/threadpool.h"
+#include "utils/uniformblock.h"
+#include "utils/renderqueue.h"
+#include "utils/commandlist.h"
+#include "utils/polyline.h"
+#include "utils/textureformats.h"
+#include "utils/mipmaps.h"
+#include "utils/textureatlas.h"
+#include "utils/spritebatch.h"
 #include "utils/inputs.h"
+#include "backends/Software/softwarerenderer.h"
 #include "kernwindow.h"
@@ -1,12 +1,18 @@
 #include <iostream>
 #include <filesystem>
+#include <functional>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <span>
 #include <string>
 #include "config.h"
 #include "utils/colors.h"
 #include "utils/vectors.h"
 #include "backends/OpenGL/openglrenderer.h"
+#include "backends/OpenGL/openglextensions.h"
+#include "backends/OpenGL/opengldebug.h"
+#include "backends/OpenGL/openglrenderthread.h"
+#include "backends/OpenGL/openglheadless.h"
 
 #include "utils/inputs.h"
 
@@ -15,6 +21,10 @@ namespace kern
     enum class GraphicsAPI
     {
         OpenGL,
+        // No visible window or display server: a surfaceless EGL context, or
+        // GLFW's OSMesa one where EGL is missing, rendering into an offscreen
+        // framebuffer. Frames are read back with Window::readPixels().
+        OpenGLHeadless,
         // Vulkan, // TODO
         // DirectX12
     };
@@ -26,43 +36,87 @@ namespace kern
             : window(nullptr), renderer(nullptr), graphics(graphics)
         {
             cast("Initializing Window");
-            if (!glfwInit())
+            const bool headless = graphics == GraphicsAPI::OpenGLHeadless;
+            // The null platform needs no X11 or Wayland connection
+            if (headless) glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+            const bool initialized = glfwInit();
+            glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+            if (!initialized)
             {
                 cast("GLFW init failed", DebugLevel::Error);
                 return;
             }
 
-            if (graphics == GraphicsAPI::OpenGL)
+            if (isOpenGL())
             {
                 glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
                 glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
                 glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if KERN_GL_VALIDATION > 0
+                // Drivers only report debug output reliably in a debug context
+                glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
 
                 cast("using: OpenGL Version 3.3");
             }
 
-            this->window = glfwCreateWindow(width, height, header.c_str(), nullptr, nullptr);
+            if (headless)
+            {
+                // GLFW's null platform can only give EGL a native window, so
+                // the context comes from EGL directly and the window, without
+                // a context, just keeps time and close state
+                headlessContext = new OpenGLHeadlessContext();
+                if (headlessContext->create(3, 3, KERN_GL_VALIDATION > 0))
+                {
+                    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+                }
+                else
+                {
+                    delete headlessContext;
+                    headlessContext = nullptr;
+                    cast("No surfaceless EGL context, falling back to OSMesa", DebugLevel::Warning);
+                    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+                }
+                glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+                this->window = glfwCreateWindow(width, height, header.c_str(), nullptr, nullptr);
+                // Hints outlive this window; later windows should be visible again
+                glfwDefaultWindowHints();
+            }
+            else
+            {
+                this->window = glfwCreateWindow(width, height, header.c_str(), nullptr, nullptr);
+            }
             if (!window)
             {
                 cast("Window creation failed", DebugLevel::Error);
+                delete headlessContext;
+                headlessContext = nullptr;
                 glfwTerminate();
                 return;
             }
 
-            glfwMakeContextCurrent(window);
+            makeContextCurrent(window, headlessContext, true);
 
             // Creating renderer
             cast("Creating Renderer...");
-            if (graphics == GraphicsAPI::OpenGL)
+            if (isOpenGL())
             {
-                if (!gladLoadGL())
+                const GLADloadproc loader = headlessContext ? OpenGLHeadlessContext::getProcAddress : (GLADloadproc)glfwGetProcAddress;
+                if (!(headlessContext ? gladLoadGLLoader(loader) : gladLoadGL()))
                 {
                     cast("Failed to initialize OpenGL context with GLAD", DebugLevel::Error);
                     glfwDestroyWindow(window);
+                    window = nullptr;
+                    delete headlessContext;
+                    headlessContext = nullptr;
                     glfwTerminate();
                     return;
                 }
-                renderer = new OpenGLRenderer(window, width, height);
+                loadOpenGLExtensions(loader);
+                enableOpenGLDebugOutput(loader);
+                OpenGLRenderer* glRenderer = new OpenGLRenderer(window, width, height);
+                if (headless) glRenderer->setOffscreen(true);
+                renderer = glRenderer;
             }
             // Other APIs later
             // else if (graphics == GraphicsAPI::Vulkan) { ... }
@@ -76,7 +130,9 @@ namespace kern
 
         ~Window()
         {
+            setThreadedRendering(false);
             delete renderer;
+            delete headlessContext;
             if (window)
             {
                 glfwDestroyWindow(window);
@@ -86,7 +142,10 @@ namespace kern
 
         void clear()
         {
-            if (isOpen() && renderer) {
+            if (CommandList* list = recording()) {
+                list->clearFramebuffer();
+            }
+            else if (isOpen() && renderer) {
                 renderer->clear();
             }
 
@@ -122,14 +181,82 @@ namespace kern
 
         void present()
         {
+            if (renderThread) {
+                // Frame N renders while the caller goes on to record N+1
+                if (packet) {
+                    renderThread->submit(packet);
+                    packet = nullptr;
+                }
+                return;
+            }
+
             if (isOpen() && renderer) {
                 renderer->present();
             }
         }
 
+        // Moves GL submission to a dedicated render thread. Draw calls on this
+        // thread are then recorded into frame packets and rendered one frame
+        // later, while input and timing stay here. Create GL resources before
+        // enabling it, or inside invokeOnRenderThread(); GL calls from this
+        // thread (shader.setX, new meshes) are not allowed meanwhile.
+        void setThreadedRendering(bool enabled)
+        {
+            if (enabled == (renderThread != nullptr)) return;
+            if (!window || !renderer || !isOpenGL()) return;
+
+            OpenGLRenderer* glRenderer = static_cast<OpenGLRenderer*>(renderer);
+
+            if (enabled) {
+                makeContextCurrent(window, headlessContext, false);
+                // By value, the thread mustn't depend on where this Window lives
+                renderThread = new OpenGLRenderThread(
+                    [window = window, context = headlessContext](bool current) { makeContextCurrent(window, context, current); },
+                    glRenderer);
+                return;
+            }
+
+            if (packet) {
+                renderThread->submit(packet);
+                packet = nullptr;
+            }
+            // Joins the render thread and takes the context back
+            delete renderThread;
+            renderThread = nullptr;
+            glRenderer->useWindowSize();
+        }
+
+        bool isThreadedRendering() const { return renderThread != nullptr; }
+
+        // The last presented frame as tightly packed RGBA8, top row first.
+        // Only headless windows keep their frames; empty otherwise, and
+        // while rendering is threaded, since the frame lives on that thread.
+        std::vector<uint8_t> readPixels() const
+        {
+            if (renderThread || !renderer || !isOpenGL()) return {};
+            return static_cast<OpenGLRenderer*>(renderer)->readPixels();
+        }
+
+        bool isHeadless() const { return graphics == GraphicsAPI::OpenGLHeadless; }
+
+        // Runs `fn` on the thread that owns the GL context, in order with the
+        // surrounding draws; immediately when rendering isn't threaded
+        void invokeOnRenderThread(std::function<void()> fn)
+        {
+            if (CommandList* list = recording()) {
+                list->invoke(std::move(fn));
+            }
+            else if (fn) {
+                fn();
+            }
+        }
+
         void clearColor(float r, float g, float b, float a = 1.0f)
         {
-            if (renderer)
+            if (CommandList* list = recording()) {
+                list->setClearColor(Color(r, g, b, a));
+            }
+            else if (renderer)
             {
                 renderer->setClearColor(r, g, b, a);
             }
@@ -137,7 +264,10 @@ namespace kern
 
         void tri(Vector2 a, Vector2 b, Vector2 c, Color color)
         {
-            if (renderer)
+            if (CommandList* list = recording()) {
+                list->tri(a, b, c, color);
+            }
+            else if (renderer)
             {
                 renderer->renderTri(a, b, c, color);
             }
@@ -146,19 +276,184 @@ namespace kern
         template<typename Vertex>
         void draw(const std::vector<Vertex>& verts, const kern::OpenGLShaderProgram& shader)
         {
-            if (renderer && graphics == GraphicsAPI::OpenGL) {
+            if (CommandList* list = recording()) {
+                list->draw(verts, shader);
+            }
+            else if (renderer && isOpenGL()) {
                 static_cast<OpenGLRenderer*>(renderer)->draw(verts, shader);
             }
         }
 
+        template<typename Vertex>
+        void draw(std::span<Vertex> verts, const kern::OpenGLShaderProgram& shader)
+        {
+            if (CommandList* list = recording()) {
+                list->draw(std::span<const Vertex>(verts), shader);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->draw(std::span<const Vertex>(verts), shader);
+            }
+        }
+
+        void draw(const Mesh& mesh, const kern::OpenGLShaderProgram& shader)
+        {
+            if (CommandList* list = recording()) {
+                list->draw(mesh, shader);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->draw(mesh, shader);
+            }
+        }
+
+        void drawIndexed(const Mesh& mesh, const kern::OpenGLShaderProgram& shader)
+        {
+            if (CommandList* list = recording()) {
+                list->draw(mesh, shader);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->drawIndexed(mesh, shader);
+            }
+        }
+
+        // One draw per atlas page and layer; the batch keeps its sprites
+        // until clear(), so static batches can be drawn every frame
+        void draw(SpriteBatch& batch)
+        {
+            if (CommandList* list = recording()) {
+                list->draw(batch);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->draw(batch);
+            }
+        }
+
+        template<typename Vertex>
+        void drawIndexed(const std::vector<Vertex>& verts, const std::vector<uint32_t>& indices, const kern::OpenGLShaderProgram& shader)
+        {
+            if (CommandList* list = recording()) {
+                list->drawIndexed(std::span<const Vertex>(verts), std::span<const uint32_t>(indices), shader);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->drawIndexed(std::span<const Vertex>(verts), std::span<const uint32_t>(indices), shader);
+            }
+        }
+
+        template<typename Instance>
+        void drawInstanced(const Mesh& mesh, const std::vector<Instance>& instances, const kern::OpenGLShaderProgram& shader)
+        {
+            if (CommandList* list = recording()) {
+                list->drawInstanced(mesh, instances, shader);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->drawInstanced(mesh, std::span<const Instance>(instances), shader);
+            }
+        }
+
+        template<typename Instance>
+        void drawInstanced(const Mesh& mesh, std::span<Instance> instances, const kern::OpenGLShaderProgram& shader)
+        {
+            if (CommandList* list = recording()) {
+                list->drawInstanced(mesh, std::span<const Instance>(instances), shader);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->drawInstanced(mesh, std::span<const Instance>(instances), shader);
+            }
+        }
+
+        // Queued until present(), then sorted by layer, transparency, shader,
+        // texture and depth to minimize state changes
+        void submit(const DrawCommand& command)
+        {
+            if (CommandList* list = recording()) {
+                list->submit(command);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->submit(command);
+            }
+        }
+
+        // Executes command lists recorded on worker threads, in the order given.
+        // Call from the thread that owns the window.
+        void submit(const CommandList& list)
+        {
+            if (CommandList* frame = recording()) {
+                // Copied, the caller may reset the list before the frame renders
+                frame->append(list);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->submit(list);
+            }
+        }
+
+        void submit(std::span<const CommandList* const> lists)
+        {
+            if (CommandList* frame = recording()) {
+                for (const CommandList* list : lists) {
+                    if (list) frame->append(*list);
+                }
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->submit(lists);
+            }
+        }
+
+        void submit(const std::vector<CommandList>& lists)
+        {
+            std::vector<const CommandList*> pointers;
+            pointers.reserve(lists.size());
+            for (const CommandList& list : lists) pointers.push_back(&list);
+            submit(std::span<const CommandList* const>(pointers));
+        }
+
+        // Camera for every shader that declares the KernFrame uniform block
+        void setCamera(const Mat4& view, const Mat4& projection)
+        {
+            if (CommandList* list = recording()) {
+                list->setCamera(view, projection);
+            }
+            else if (renderer && isOpenGL()) {
+                static_cast<OpenGLRenderer*>(renderer)->setCamera(view, projection);
+            }
+        }
+
+        // Writable vertex memory in GPU-visible storage, valid for this frame
+        template<typename Vertex>
+        std::span<Vertex> map(size_t count)
+        {
+            if (CommandList* list = recording()) {
+                return list->allocate<Vertex>(count);
+            }
+            if (renderer && isOpenGL()) {
+                return static_cast<OpenGLRenderer*>(renderer)->map<Vertex>(count);
+            }
+            return {};
+        }
+
+        // Thickness is in pixels
         void line(Vector2 a, Vector2 b, Color color, float thickness = 1.0f)
         {
-            if (renderer)
+            if (CommandList* list = recording()) {
+                list->line(a, b, color, thickness);
+            }
+            else if (renderer)
             {
                 renderer->renderLine(a, b, color, thickness);
             }
         }
 
+        // Connected line strip, expanded with joins and caps into a single draw.
+        // Width is in pixels.
+        void polyline(std::span<const Vector2> points, float width, Color color, const PolylineStyle& style = {})
+        {
+            if (CommandList* list = recording()) {
+                list->polyline(points, width, color, style);
+            }
+            else if (renderer)
+            {
+                renderer->renderPolyline(points, width, color, style);
+            }
+        }
+
         void setTitle(std::string title)
         {
             if (window)
@@ -177,12 +472,55 @@ namespace kern
 
         void circle(Vector2 center, float radius, Color color)
         {
-            if (renderer)
+            if (CommandList* list = recording()) {
+                list->circle(center, radius, color);
+            }
+            else if (renderer)
             {
                 renderer->renderCircle(center, radius, color);
             }
         }
 
+        // position is the bottom-left corner, in the same NDC space as circle()
+        void rect(Vector2 position, Vector2 size, Color color)
+        {
+            roundedRect(position, size, 0.0f, color);
+        }
+
+        void roundedRect(Vector2 position, Vector2 size, float radius, Color color)
+        {
+            if (CommandList* list = recording()) {
+                list->rect(position, size, color, radius);
+            }
+            else if (renderer)
+            {
+                renderer->renderRect(position, size, radius, color);
+            }
+        }
+
+        void ellipse(Vector2 center, Vector2 radii, Color color)
+        {
+            if (CommandList* list = recording()) {
+                list->ellipse(center, radii, color);
+            }
+            else if (renderer)
+            {
+                renderer->renderEllipse(center, radii, 0.0f, color);
+            }
+        }
+
+        // Outline of a circle; thickness is measured inward from the radius
+        void ring(Vector2 center, float radius, float thickness, Color color)
+        {
+            if (CommandList* list = recording()) {
+                list->ellipse(center, Vector2(radius, radius), color, thickness);
+            }
+            else if (renderer)
+            {
+                renderer->renderEllipse(center, Vector2(radius, radius), thickness, color);
+            }
+        }
+
         int getFPS() const
         {
             if (isOpen() && window)
@@ -194,6 +532,15 @@ namespace kern
 
         float getDeltaTime() const { return m_deltaTime; }
 
+        // Draw calls and state changes of the last presented frame
+        RenderStats getRenderStats() const
+        {
+            if (renderThread) {
+                return renderThread->getStats();
+            }
+            return renderer ? renderer->getStats() : RenderStats{};
+        }
+
         float getTime() const
         {
             if (isOpen() && window)
@@ -370,7 +717,8 @@ namespace kern
 
         void setVsync(bool enabled)
         {
-            if (window)
+            // Headless frames are never swapped
+            if (window && !isHeadless())
             {
                 glfwSwapInterval(enabled ? 1 : 0);
             }
@@ -400,6 +748,35 @@ namespace kern
         GLFWwindow* window;
         Renderer* renderer; 
         GraphicsAPI graphics;
+        // Owns the GL context of headless windows, unless OSMesa does
+        OpenGLHeadlessContext* headlessContext = nullptr;
+
+        // Threaded rendering: the packet this frame is being recorded into
+        OpenGLRenderThread* renderThread = nullptr;
+        FramePacket* packet = nullptr;
+
+        bool isOpenGL() const
+        {
+            return graphics == GraphicsAPI::OpenGL || graphics == GraphicsAPI::OpenGLHeadless;
+        }
+
+        static void makeContextCurrent(GLFWwindow* window, OpenGLHeadlessContext* headlessContext, bool current)
+        {
+            if (headlessContext) headlessContext->makeCurrent(current);
+            else glfwMakeContextCurrent(current ? window : nullptr);
+        }
+
+        CommandList* recording()
+        {
+            if (!renderThread) return nullptr;
+
+            if (!packet) {
+                packet = renderThread->acquire();
+                // GLFW only reports the window size on this thread
+                getSize(packet->width, packet->height);
+            }
+            return &packet->commands;
+        }
 
         double previousTime;
         int frameCount = 0;
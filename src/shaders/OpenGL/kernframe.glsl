@@ -0,0 +1,10 @@
+// Per-frame constants, filled by the renderer at binding 0
+layout(std140) uniform KernFrame
+{
+    mat4 u_View;
+    mat4 u_Projection;
+    mat4 u_ViewProjection;
+    vec4 u_Viewport;
+    float u_Time;
+    float u_DeltaTime;
+};
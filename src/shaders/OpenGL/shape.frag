@@ -0,0 +1,52 @@
+#version 330 core
+in vec2 v_Local;
+flat in vec2 v_HalfSize;
+flat in vec4 v_Color;
+flat in vec4 v_Params;
+
+out vec4 FragColor;
+
+// Shape types, see OpenGLRenderer::ShapeType
+const float SHAPE_RECT = 0.0;
+
+float roundedRectDistance(vec2 p, vec2 halfSize, float radius)
+{
+    radius = min(radius, min(halfSize.x, halfSize.y));
+    vec2 q = abs(p) - halfSize + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+// Close to the true distance near the edge, which is all coverage needs
+float ellipseDistance(vec2 p, vec2 radii)
+{
+    float k0 = length(p / radii);
+    float k1 = length(p / (radii * radii));
+    return k1 > 0.0 ? k0 * (k0 - 1.0) / k1 : -min(radii.x, radii.y);
+}
+
+void main()
+{
+    float d;
+    if (v_Params.y == SHAPE_RECT)
+    {
+        d = roundedRectDistance(v_Local, v_HalfSize, v_Params.x);
+    }
+    else // Ellipse
+    {
+        d = ellipseDistance(v_Local, v_HalfSize);
+        // Rings keep a band of the given thickness around the outline
+        if (v_Params.x > 0.0)
+        {
+            d = abs(d + v_Params.x * 0.5) - v_Params.x * 0.5;
+        }
+    }
+
+    // Distance is in NDC, fwidth turns it into pixels for a one pixel ramp
+    float coverage = clamp(0.5 - d / max(fwidth(d), 1e-6), 0.0, 1.0);
+    if (coverage <= 0.0)
+    {
+        discard;
+    }
+
+    FragColor = vec4(v_Color.rgb, v_Color.a * coverage);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+// One instanced quad per shape, corners generated from gl_VertexID
+layout (location = 0) in vec4 i_Bounds;  // center.xy, halfSize.xy (NDC)
+layout (location = 1) in vec4 i_Color;
+layout (location = 2) in vec4 i_Params;  // cornerRadius / thickness, type
+
+#include "kernframe.glsl"
+
+out vec2 v_Local;
+flat out vec2 v_HalfSize;
+flat out vec4 v_Color;
+flat out vec4 v_Params;
+
+void main()
+{
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+
+    // Grow the quad by two pixels so the anti-aliased edge isn't clipped
+    vec2 margin = 4.0 / max(u_Viewport.zw, vec2(1.0));
+    vec2 local = corner * (i_Bounds.zw + margin);
+
+    gl_Position = vec4(i_Bounds.xy + local, 0.0, 1.0);
+    v_Local = local;
+    v_HalfSize = i_Bounds.zw;
+    v_Color = i_Color;
+    v_Params = i_Params;
+}
@@ -0,0 +1,27 @@
+#version 330 core
+// One instanced quad per sprite, corners generated from gl_VertexID
+layout (location = 0) in vec4 i_Bounds;  // center.xy, halfSize.xy (NDC)
+layout (location = 1) in vec4 i_UV;      // uvMin.xy, uvMax.xy
+layout (location = 2) in vec4 i_Color;
+layout (location = 3) in vec4 i_Params;  // rotation
+
+#include "kernframe.glsl"
+
+out vec2 v_UV;
+out vec4 v_Color;
+
+void main()
+{
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+
+    // Rotate in pixels, so sprites keep their shape on non-square windows
+    vec2 pixelsPerUnit = max(u_Viewport.zw, vec2(1.0)) * 0.5;
+    vec2 local = (corner * 2.0 - 1.0) * i_Bounds.zw * pixelsPerUnit;
+    float s = sin(i_Params.x);
+    float c = cos(i_Params.x);
+    local = vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position = vec4(i_Bounds.xy + local / pixelsPerUnit, 0.0, 1.0);
+    v_UV = mix(i_UV.xy, i_UV.zw, corner);
+    v_Color = i_Color;
+}
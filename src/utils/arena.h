@@ -0,0 +1,87 @@
+// src/utils/arena.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace kern {
+
+// Bump allocator over fixed-size blocks. Allocations never move, so pointers
+// stay valid until reset(), which rewinds without freeing: after the first
+// few frames a per-frame arena stops touching the heap entirely.
+// Not thread-safe; give each thread its own arena.
+class LinearArena {
+public:
+    explicit LinearArena(size_t blockSize = 256 * 1024)
+        : blockSize(blockSize) {}
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+    LinearArena(LinearArena&&) noexcept = default;
+    LinearArena& operator=(LinearArena&&) noexcept = default;
+
+    void* allocate(size_t size, size_t alignment)
+    {
+        if (size == 0) return nullptr;
+
+        while (current < blocks.size()) {
+            Block& block = blocks[current];
+            const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            const uintptr_t aligned = (base + block.used + alignment - 1) & ~uintptr_t(alignment - 1);
+            const size_t end = size_t(aligned - base) + size;
+
+            if (end <= block.size) {
+                block.used = end;
+                used += size;
+                return reinterpret_cast<void*>(aligned);
+            }
+            current++;
+        }
+
+        // Oversized requests get a block of their own
+        const size_t capacity = size + alignment > blockSize ? size + alignment : blockSize;
+        blocks.push_back({ std::make_unique<std::byte[]>(capacity), capacity, 0 });
+        current = blocks.size() - 1;
+        return allocate(size, alignment);
+    }
+
+    template<typename T>
+    std::span<T> allocate(size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Arena memory is never destructed");
+        return { static_cast<T*>(allocate(count * sizeof(T), alignof(T))), count };
+    }
+
+    void reset()
+    {
+        for (Block& block : blocks) block.used = 0;
+        current = 0;
+        used = 0;
+    }
+
+    size_t getUsedBytes() const { return used; }
+    size_t getCapacity() const
+    {
+        size_t total = 0;
+        for (const Block& block : blocks) total += block.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+        size_t used = 0;
+    };
+
+    std::vector<Block> blocks;
+    size_t blockSize;
+    size_t current = 0;
+    size_t used = 0;
+};
+
+} // namespace kern
@@ -0,0 +1,149 @@
+#include "commandlist.h"
+
+#include <algorithm>
+
+namespace {
+
+// Polyline points follow their header in the same arena allocation
+constexpr size_t polylineAlignment = std::max(alignof(kern::CommandList::PolylineData), alignof(kern::Vector2));
+static_assert(sizeof(kern::CommandList::PolylineData) % alignof(kern::Vector2) == 0, "Polyline points would be misaligned");
+
+} // namespace
+
+void kern::CommandList::pushShape(CommandType type, const ShapeData& shape)
+{
+    Command command{ type };
+    command.data = copyBytes(&shape, sizeof(shape), alignof(ShapeData));
+    if (command.data) commands.push_back(command);
+}
+
+void kern::CommandList::draw(SpriteBatch& batch)
+{
+    batch.sort();
+    for (const SpriteBatch::Range& range : batch.getRanges()) {
+        const void* data = copy(range.instances);
+        if (!data) continue;
+
+        Command command{ CommandType::DrawSprites };
+        command.data = data;
+        command.count = range.instances.size();
+        command.stride = sizeof(SpriteInstance);
+        command.texture = range.texture;
+        commands.push_back(command);
+    }
+}
+
+void kern::CommandList::tri(Vector2 a, Vector2 b, Vector2 c, Color color)
+{
+    pushShape(CommandType::Tri, { a, b, c, color, 0.0f });
+}
+
+void kern::CommandList::line(Vector2 a, Vector2 b, Color color, float thickness)
+{
+    pushShape(CommandType::Line, { a, b, {}, color, thickness });
+}
+
+void kern::CommandList::polyline(std::span<const Vector2> points, float width, Color color, const PolylineStyle& style)
+{
+    if (points.size() < 2) return;
+
+    // Header and points share one allocation, so append() copies them together
+    const PolylineData header{ color, width, style };
+    void* data = arena.allocate(sizeof(PolylineData) + points.size_bytes(), polylineAlignment);
+    if (!data) return;
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(static_cast<std::byte*>(data) + sizeof(PolylineData), points.data(), points.size_bytes());
+
+    Command command{ CommandType::Polyline };
+    command.data = data;
+    command.count = points.size();
+    commands.push_back(command);
+}
+
+void kern::CommandList::circle(Vector2 center, float radius, Color color)
+{
+    pushShape(CommandType::Circle, { center, {}, {}, color, radius });
+}
+
+void kern::CommandList::rect(Vector2 position, Vector2 size, Color color, float cornerRadius)
+{
+    pushShape(CommandType::Rect, { position, size, {}, color, cornerRadius });
+}
+
+void kern::CommandList::ellipse(Vector2 center, Vector2 radii, Color color, float thickness)
+{
+    pushShape(CommandType::Ellipse, { center, radii, {}, color, thickness });
+}
+
+void kern::CommandList::setClearColor(Color color)
+{
+    Command command{ CommandType::ClearColor };
+    command.data = copyBytes(&color, sizeof(color), alignof(Color));
+    if (command.data) commands.push_back(command);
+}
+
+void kern::CommandList::clearFramebuffer()
+{
+    commands.push_back({ CommandType::Clear });
+}
+
+void kern::CommandList::setCamera(const Mat4& view, const Mat4& projection)
+{
+    const CameraData camera{ view, projection };
+
+    Command command{ CommandType::SetCamera };
+    command.data = copyBytes(&camera, sizeof(camera), alignof(CameraData));
+    if (command.data) commands.push_back(command);
+}
+
+void kern::CommandList::invoke(std::function<void()> fn)
+{
+    if (!fn) return;
+
+    Command command{ CommandType::Invoke };
+    command.count = callbacks.size();
+    callbacks.push_back(std::move(fn));
+    commands.push_back(command);
+}
+
+void kern::CommandList::append(const CommandList& other)
+{
+    commands.reserve(commands.size() + other.commands.size());
+
+    for (Command command : other.commands) {
+        switch (command.type) {
+            case CommandType::DrawVertices:
+            case CommandType::DrawInstanced:
+            case CommandType::DrawSprites:
+                command.data = copyBytes(command.data, command.count * command.stride, alignof(float));
+                break;
+            case CommandType::DrawIndexedVertices:
+                command.data = copyBytes(command.data, command.count * command.stride, alignof(float));
+                command.indices = static_cast<const uint32_t*>(copyBytes(command.indices, command.indexCount * sizeof(uint32_t), alignof(uint32_t)));
+                break;
+            case CommandType::Tri:
+            case CommandType::Line:
+            case CommandType::Circle:
+            case CommandType::Rect:
+            case CommandType::Ellipse:
+                command.data = copyBytes(command.data, sizeof(ShapeData), alignof(ShapeData));
+                break;
+            case CommandType::Polyline:
+                command.data = copyBytes(command.data, sizeof(PolylineData) + command.count * sizeof(Vector2), polylineAlignment);
+                break;
+            case CommandType::ClearColor:
+                command.data = copyBytes(command.data, sizeof(Color), alignof(Color));
+                break;
+            case CommandType::SetCamera:
+                command.data = copyBytes(command.data, sizeof(CameraData), alignof(CameraData));
+                break;
+            case CommandType::Invoke:
+                callbacks.push_back(other.callbacks[command.count]);
+                command.count = callbacks.size() - 1;
+                break;
+            default:
+                break;
+        }
+        commands.push_back(command);
+    }
+}
@@ -0,0 +1,244 @@
+// src/utils/commandlist.h
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "utils/arena.h"
+#include "utils/colors.h"
+#include "utils/polyline.h"
+#include "utils/renderqueue.h"
+#include "utils/spritebatch.h"
+
+namespace kern {
+
+class Mesh;
+class OpenGLShaderProgram;
+
+// Draws recorded on any thread and executed later on the render thread with
+// Window::submit(). Recording makes no GL calls: vertex and instance data is
+// copied into the list's own arena and only streamed to the GPU on submit.
+// One list per worker thread; lists are not shared while recording.
+class CommandList {
+public:
+    enum class CommandType : uint8_t {
+        Draw,                 // DrawCommand executed in recorded order
+        DrawMesh,             // Mesh as-is, like Window::draw(mesh, shader)
+        Submit,               // DrawCommand handed to the frame's sorted RenderQueue
+        DrawVertices,         // Vertices from the arena
+        DrawIndexedVertices,  // Vertices and indices from the arena
+        DrawInstanced,        // Mesh with instance data from the arena
+        DrawSprites,          // SpriteInstances from the arena, one atlas page (texture)
+        Tri,                  // ShapeData
+        Line,                 // ShapeData
+        Polyline,             // PolylineData followed by count points
+        Circle,               // ShapeData
+        Rect,                 // ShapeData
+        Ellipse,              // ShapeData
+        ClearColor,           // Color
+        Clear,
+        SetCamera,            // CameraData
+        Invoke                // callbacks[count]
+    };
+
+    struct ShapeData {
+        Vector2 a, b, c;
+        Color color;
+        float size;  // Line thickness, circle radius, corner radius or ring thickness
+    };
+
+    struct PolylineData {
+        Color color;
+        float width;
+        PolylineStyle style;
+    };
+
+    struct CameraData {
+        Mat4 view;
+        Mat4 projection;
+    };
+
+    struct Command {
+        CommandType type{};
+        DrawCommand draw{};                            // Draw, Submit, DrawMesh / DrawInstanced (mesh)
+        const OpenGLShaderProgram* shader = nullptr;   // DrawMesh, DrawVertices, DrawIndexedVertices, DrawInstanced
+        const void* data = nullptr;                    // Arena payload
+        size_t count = 0;
+        size_t stride = 0;
+        const uint32_t* indices = nullptr;             // DrawIndexedVertices
+        size_t indexCount = 0;
+        GLuint texture = 0;                            // DrawSprites
+    };
+
+    explicit CommandList(size_t arenaBlockSize = 256 * 1024)
+        : arena(arenaBlockSize) {}
+
+    CommandList(const CommandList&) = delete;
+    CommandList& operator=(const CommandList&) = delete;
+    CommandList(CommandList&&) noexcept = default;
+    CommandList& operator=(CommandList&&) noexcept = default;
+
+    void draw(const DrawCommand& command)
+    {
+        if (!command.mesh || !command.shader) return;
+        commands.push_back({ CommandType::Draw, command });
+    }
+
+    void submit(const DrawCommand& command)
+    {
+        if (!command.mesh || !command.shader) return;
+        commands.push_back({ CommandType::Submit, command });
+    }
+
+    // Uses whatever uniforms the shader holds when the command executes
+    void draw(const Mesh& mesh, const OpenGLShaderProgram& shader)
+    {
+        Command command{ CommandType::DrawMesh };
+        command.draw.mesh = &mesh;
+        command.shader = &shader;
+        commands.push_back(command);
+    }
+
+    template<typename Vertex>
+    void draw(std::span<const Vertex> vertices, const OpenGLShaderProgram& shader)
+    {
+        if (vertices.empty()) return;
+        const void* data = copy(vertices);
+        if (!data) return;
+
+        Command command{ CommandType::DrawVertices };
+        command.shader = &shader;
+        command.data = data;
+        command.count = vertices.size();
+        command.stride = sizeof(Vertex);
+        commands.push_back(command);
+    }
+
+    template<typename Vertex>
+    void draw(const std::vector<Vertex>& vertices, const OpenGLShaderProgram& shader)
+    {
+        draw(std::span<const Vertex>(vertices), shader);
+    }
+
+    template<typename Vertex>
+    void drawIndexed(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const OpenGLShaderProgram& shader)
+    {
+        if (vertices.empty() || indices.empty()) return;
+        const void* data = copy(vertices);
+        const void* indexData = copy(indices);
+        if (!data || !indexData) return;
+
+        Command command{ CommandType::DrawIndexedVertices };
+        command.shader = &shader;
+        command.data = data;
+        command.count = vertices.size();
+        command.stride = sizeof(Vertex);
+        command.indices = static_cast<const uint32_t*>(indexData);
+        command.indexCount = indices.size();
+        commands.push_back(command);
+    }
+
+    template<typename Instance>
+    void drawInstanced(const Mesh& mesh, std::span<const Instance> instances, const OpenGLShaderProgram& shader)
+    {
+        if (instances.empty()) return;
+        const void* data = copy(instances);
+        if (!data) return;
+
+        Command command{ CommandType::DrawInstanced };
+        command.draw.mesh = &mesh;
+        command.shader = &shader;
+        command.data = data;
+        command.count = instances.size();
+        command.stride = sizeof(Instance);
+        commands.push_back(command);
+    }
+
+    template<typename Instance>
+    void drawInstanced(const Mesh& mesh, const std::vector<Instance>& instances, const OpenGLShaderProgram& shader)
+    {
+        drawInstanced(mesh, std::span<const Instance>(instances), shader);
+    }
+
+    // Sorts the batch and records one command per range, copying the instances
+    void draw(SpriteBatch& batch);
+
+    // The immediate-mode shapes and frame state of Window, recorded
+    void tri(Vector2 a, Vector2 b, Vector2 c, Color color);
+    void line(Vector2 a, Vector2 b, Color color, float thickness);
+    void polyline(std::span<const Vector2> points, float width, Color color, const PolylineStyle& style = {});
+    void circle(Vector2 center, float radius, Color color);
+    void rect(Vector2 position, Vector2 size, Color color, float cornerRadius = 0.0f);
+    void ellipse(Vector2 center, Vector2 radii, Color color, float thickness = 0.0f);
+    void setClearColor(Color color);
+    void clearFramebuffer();
+    void setCamera(const Mat4& view, const Mat4& projection);
+
+    // Runs on the render thread, in order with the surrounding commands.
+    // The way to touch GL objects (uniforms, uploads) from a recording thread.
+    void invoke(std::function<void()> fn);
+
+    // Copies another list's commands and data to the end of this one
+    void append(const CommandList& other);
+
+    // Scratch memory owned by the list, valid until reset(); fill it and pass
+    // the span to draw()/drawInstanced() without another copy
+    template<typename T>
+    std::span<T> allocate(size_t count)
+    {
+        std::span<T> span = arena.allocate<T>(count);
+        lastAllocation = span.data();
+        return span;
+    }
+
+    // Forgets the commands and rewinds the arena, keeping its memory
+    void reset()
+    {
+        commands.clear();
+        callbacks.clear();
+        arena.reset();
+        lastAllocation = nullptr;
+    }
+
+    bool empty() const { return commands.empty(); }
+    size_t size() const { return commands.size(); }
+    const std::vector<Command>& getCommands() const { return commands; }
+    size_t getArenaBytes() const { return arena.getUsedBytes(); }
+
+    // Called by the renderer for Invoke commands
+    void runCallback(const Command& command) const
+    {
+        if (command.count < callbacks.size() && callbacks[command.count]) callbacks[command.count]();
+    }
+
+private:
+    std::vector<Command> commands;
+    std::vector<std::function<void()>> callbacks;
+    LinearArena arena;
+    const void* lastAllocation = nullptr;
+
+    template<typename T>
+    const void* copy(std::span<const T> items)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Command list data is copied byte-wise");
+
+        // Already sitting in the arena from allocate()
+        if (items.data() == lastAllocation) return items.data();
+
+        return copyBytes(items.data(), items.size_bytes(), alignof(T));
+    }
+
+    const void* copyBytes(const void* data, size_t size, size_t alignment)
+    {
+        void* dst = arena.allocate(size, alignment);
+        if (dst) std::memcpy(dst, data, size);
+        return dst;
+    }
+
+    void pushShape(CommandType type, const ShapeData& shape);
+};
+
+} // namespace kern
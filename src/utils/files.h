@@ -4,6 +4,8 @@
 #include <sstream>
 #include <iostream>
 #include <filesystem>
+#include <cstdint>
+#include <vector>
 
 namespace kern {
     inline std::string readFile(const std::string& filepath)
@@ -22,4 +24,25 @@ namespace kern {
         fileStream.close();
         return content;
     }
-}
+
+    // Whole file as bytes; empty if it can't be read
+    inline std::vector<uint8_t> readBinaryFile(const std::string& filepath)
+    {
+        std::ifstream fileStream(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!fileStream.is_open()) {
+            return {};
+        }
+
+        const std::streamsize size = fileStream.tellg();
+        if (size <= 0) {
+            return {};
+        }
+
+        std::vector<uint8_t> bytes(static_cast<size_t>(size));
+        fileStream.seekg(0);
+        if (!fileStream.read(reinterpret_cast<char*>(bytes.data()), size)) {
+            return {};
+        }
+        return bytes;
+    }
+}
\ No newline at end of file
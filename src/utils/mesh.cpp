@@ -0,0 +1,174 @@
+#include "mesh.h"
+
+void kern::bindVertexAttributes(const VertexLayout& layout, bool perInstance, size_t baseOffset)
+{
+    const size_t stride = perInstance ? layout.getInstanceStride() : layout.getStride();
+
+    for (const auto& elem : layout.getElements()) {
+        if (elem.isPerInstance() != perInstance) continue;
+
+        for (int i = 0; i < elem.getLocationCount(); i++) {
+            const GLuint location = static_cast<GLuint>(elem.index + i);
+            const size_t offset = baseOffset + elem.offset + i * sizeof(float) * 4;
+
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(
+                location,
+                static_cast<GLint>(elem.getTypeComponentCount()),
+                GL_FLOAT,
+                GL_FALSE,
+                static_cast<GLsizei>(stride),
+                (void*)offset
+            );
+            glVertexAttribDivisor(location, elem.divisor);
+        }
+    }
+}
+
+kern::Mesh::Mesh(const void* vertices, size_t vertexCount, size_t stride,
+                 const uint32_t* indices, size_t indexCount,
+                 const VertexLayout& layout, MeshUsage usage)
+    : layout(layout), vertexCount(vertexCount), stride(stride)
+{
+    if (!layout.empty() && layout.getStride() != stride) {
+        cast("Mesh: layout stride does not match vertex size!", DebugLevel::Error);
+        this->vertexCount = 0;
+        return;
+    }
+
+    glGenBuffers(1, &vbo);
+    if (!vbo) {
+        cast("Mesh: failed to generate VBO!", DebugLevel::Error);
+        this->vertexCount = 0;
+        return;
+    }
+
+    // Uploaded through the copy target so no VAO's state is disturbed
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCount * stride, vertices,
+                 usage == MeshUsage::Dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (indices && indexCount > 0) {
+        glGenBuffers(1, &ibo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+
+        if (vertexCount <= maxShortIndexVertices) {
+            // Half the index memory and bandwidth for small meshes
+            std::vector<uint16_t> shortIndices(indices, indices + indexCount);
+            glBufferData(GL_COPY_WRITE_BUFFER, indexCount * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+            indexType = GL_UNSIGNED_SHORT;
+        } else {
+            glBufferData(GL_COPY_WRITE_BUFFER, indexCount * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+            indexType = GL_UNSIGNED_INT;
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        this->indexCount = indexCount;
+    }
+
+    cast("Mesh uploaded: " + std::to_string(vertexCount) + " vertices, " + std::to_string(this->indexCount) + " indices", DebugLevel::Everything);
+}
+
+kern::Mesh::~Mesh()
+{
+    release();
+}
+
+kern::Mesh::Mesh(Mesh&& other) noexcept
+    : layout(std::move(other.layout))
+    , vbo(other.vbo)
+    , vertexCount(other.vertexCount)
+    , stride(other.stride)
+    , ibo(other.ibo)
+    , indexCount(other.indexCount)
+    , indexType(other.indexType)
+    , vaos(std::move(other.vaos))
+{
+    other.vbo = 0;
+    other.vertexCount = 0;
+    other.ibo = 0;
+    other.indexCount = 0;
+    other.vaos.clear();
+}
+
+kern::Mesh& kern::Mesh::operator=(Mesh&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        layout = std::move(other.layout);
+        vbo = other.vbo;
+        vertexCount = other.vertexCount;
+        stride = other.stride;
+        ibo = other.ibo;
+        indexCount = other.indexCount;
+        indexType = other.indexType;
+        vaos = std::move(other.vaos);
+
+        other.vbo = 0;
+        other.vertexCount = 0;
+        other.ibo = 0;
+        other.indexCount = 0;
+        other.vaos.clear();
+    }
+    return *this;
+}
+
+void kern::Mesh::release()
+{
+    for (auto& [hash, vao] : vaos) {
+        gl::deleteVertexArray(vao);
+    }
+    vaos.clear();
+
+    if (vbo) {
+        gl::deleteBuffer(vbo);
+        vbo = 0;
+    }
+
+    if (ibo) {
+        gl::deleteBuffer(ibo);
+        ibo = 0;
+    }
+}
+
+void kern::Mesh::update(size_t firstVertex, const void* vertices, size_t count)
+{
+    if (!vbo || count == 0) return;
+
+    if (firstVertex + count > vertexCount) {
+        cast("Mesh update out of range: " + std::to_string(firstVertex + count) + " > " + std::to_string(vertexCount), DebugLevel::Error);
+        return;
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, firstVertex * stride, count * stride, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void kern::Mesh::bind(const VertexLayout& layout) const
+{
+    const size_t hash = layout.getHash();
+
+    for (const auto& [key, vao] : vaos) {
+        if (key == hash) {
+            gl::bindVertexArray(vao);
+            return;
+        }
+    }
+
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    gl::bindVertexArray(vao);
+    gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    // Element buffer binding is VAO state
+    if (ibo) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    }
+
+    // Per-instance elements are pointed at the instance data on every draw
+    bindVertexAttributes(layout, false);
+
+    vaos.push_back({ hash, vao });
+}
@@ -0,0 +1,123 @@
+// src/utils/mesh.h
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+#include "config.h"
+#include "utils/vertexlayout.h"
+#include "utils/meshoptimizer.h"
+#include "backends/OpenGL/openglstate.h"
+
+namespace kern {
+
+// Points the elements of one stream (per-vertex or per-instance) at the
+// buffer bound to GL_ARRAY_BUFFER, starting at baseOffset. Mat4 elements are
+// spread over four consecutive vec4 locations.
+void bindVertexAttributes(const VertexLayout& layout, bool perInstance, size_t baseOffset = 0);
+
+enum class MeshUsage {
+    Static,  // Uploaded once
+    Dynamic  // Expect frequent update() calls
+};
+
+// Vertex data that lives on the GPU. Uploaded once, then drawn by handle
+// through Window::draw(mesh, shader) without touching the vertices again.
+// Indexed meshes store 16-bit indices whenever the vertex count allows it.
+class Mesh {
+public:
+    Mesh() = default;
+
+    template<typename Vertex>
+    Mesh(const std::vector<Vertex>& vertices, const VertexLayout& layout = {}, MeshUsage usage = MeshUsage::Static)
+        : Mesh(vertices.data(), vertices.size(), sizeof(Vertex), nullptr, 0, layout, usage) {}
+
+    template<typename Vertex>
+    Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const VertexLayout& layout = {}, MeshUsage usage = MeshUsage::Static)
+        : Mesh(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size(), layout, usage) {}
+
+    Mesh(const void* vertices, size_t vertexCount, size_t stride,
+         const uint32_t* indices, size_t indexCount,
+         const VertexLayout& layout = {}, MeshUsage usage = MeshUsage::Static);
+    ~Mesh();
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    Mesh(Mesh&& other) noexcept;
+    Mesh& operator=(Mesh&& other) noexcept;
+
+    // Overwrites vertices [firstVertex, firstVertex + count) in place
+    template<typename Vertex>
+    void update(size_t firstVertex, std::span<const Vertex> vertices)
+    {
+        if (sizeof(Vertex) != stride) {
+            cast("Mesh update: vertex size mismatch!", DebugLevel::Error);
+            return;
+        }
+        update(firstVertex, vertices.data(), vertices.size());
+    }
+
+    template<typename Vertex>
+    void update(size_t firstVertex, const std::vector<Vertex>& vertices)
+    {
+        update(firstVertex, std::span<const Vertex>(vertices));
+    }
+
+    void update(size_t firstVertex, const void* vertices, size_t count);
+
+    // Binds a VAO that feeds `layout` from this mesh, created on first use
+    // and cached per layout hash
+    void bind(const VertexLayout& layout) const;
+
+    size_t getVertexCount() const { return vertexCount; }
+    size_t getStride() const { return stride; }
+    const VertexLayout& getLayout() const { return layout; }
+    GLuint getBuffer() const { return vbo; }
+    bool isValid() const { return vbo != 0; }
+
+    bool isIndexed() const { return ibo != 0; }
+    size_t getIndexCount() const { return indexCount; }
+    GLenum getIndexType() const { return indexType; }  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+
+private:
+    VertexLayout layout;
+    GLuint vbo = 0;
+    size_t vertexCount = 0;
+    size_t stride = 0;
+
+    GLuint ibo = 0;
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // A mesh rarely meets more than a couple of layouts, a flat list is enough
+    mutable std::vector<std::pair<size_t, GLuint>> vaos;
+
+    void release();
+};
+
+template<typename Vertex>
+inline Mesh createMesh(const std::vector<Vertex>& vertices, const VertexLayout& layout = {}, MeshUsage usage = MeshUsage::Static)
+{
+    return Mesh(vertices, layout, usage);
+}
+
+// Welds, cache-orders and fetch-orders triangle soup, then uploads it indexed
+template<typename Vertex>
+inline Mesh createOptimizedMesh(const std::vector<Vertex>& soup, const VertexLayout& layout = {}, MeshOptimizerReport* report = nullptr)
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    MeshOptimizerReport result = optimizeMesh(soup, vertices, indices);
+
+    cast("Mesh optimized: " + std::to_string(result.inputVertices) + " -> " + std::to_string(result.weldedVertices) +
+         " vertices, ACMR " + std::to_string(result.cacheBefore.acmr) + " -> " + std::to_string(result.cacheAfter.acmr),
+         DebugLevel::Everything);
+
+    if (report) *report = result;
+    return Mesh(vertices, indices, layout);
+}
+
+} // namespace kern
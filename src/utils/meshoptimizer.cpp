@@ -0,0 +1,329 @@
+#include "meshoptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// FNV-1a over the raw vertex bytes
+size_t hashBytes(const uint8_t* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+size_t nextPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+// Forsyth's tuning constants
+constexpr size_t forsythCacheSize = 32;
+constexpr float cacheDecayPower = 1.5f;
+constexpr float lastTriScore = 0.75f;
+constexpr float valenceBoostScale = 2.0f;
+constexpr float valenceBoostPower = 0.5f;
+
+float computeVertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // The three vertices of the last triangle score the same, so the
+            // algorithm doesn't prefer strips over fans
+            score = lastTriScore;
+        } else {
+            const float scaler = 1.0f / (forsythCacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, cacheDecayPower);
+        }
+    }
+
+    // Prioritize vertices with few triangles left, so they can be retired
+    score += valenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -valenceBoostPower);
+    return score;
+}
+
+// Scores are looked up per step, so the pow() calls are tabulated up front
+constexpr uint32_t maxTabulatedValence = 32;
+
+struct ScoreTable {
+    float values[forsythCacheSize + 1][maxTabulatedValence];
+
+    ScoreTable() {
+        for (int position = -1; position < int(forsythCacheSize); position++) {
+            for (uint32_t valence = 0; valence < maxTabulatedValence; valence++) {
+                values[position + 1][valence] = computeVertexScore(position, valence);
+            }
+        }
+    }
+};
+
+float vertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+    static const ScoreTable table;
+
+    if (remainingTriangles >= maxTabulatedValence) {
+        return computeVertexScore(cachePosition, remainingTriangles);
+    }
+    return table.values[cachePosition + 1][remainingTriangles];
+}
+
+} // namespace
+
+std::vector<uint32_t> kern::weldVertices(const void* vertices, size_t count, size_t stride, std::vector<uint8_t>& unique)
+{
+    std::vector<uint32_t> indices(count);
+    unique.clear();
+    if (count == 0 || stride == 0) return indices;
+
+    const uint8_t* src = static_cast<const uint8_t*>(vertices);
+
+    // Open addressing table of unique vertex ids, kept at most half full
+    const size_t tableSize = nextPowerOfTwo(count * 2);
+    const uint32_t empty = ~0u;
+    std::vector<uint32_t> table(tableSize, empty);
+
+    unique.reserve(count * stride);
+    uint32_t uniqueCount = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* vertex = src + i * stride;
+        size_t slot = hashBytes(vertex, stride) & (tableSize - 1);
+
+        while (true) {
+            uint32_t id = table[slot];
+            if (id == empty) {
+                table[slot] = uniqueCount;
+                unique.insert(unique.end(), vertex, vertex + stride);
+                indices[i] = uniqueCount++;
+                break;
+            }
+            if (std::memcmp(unique.data() + size_t(id) * stride, vertex, stride) == 0) {
+                indices[i] = id;
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+    }
+
+    return indices;
+}
+
+void kern::optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) return;
+
+    // Vertex -> triangle adjacency as one flat array
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        remaining[indices[i]]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+    }
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        score[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+
+    // Simulated LRU cache, with room for the 3 vertices pushed in per step
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> nextCache;
+    cache.reserve(forsythCacheSize + 3);
+    nextCache.reserve(forsythCacheSize + 3);
+
+    size_t scanCursor = 0;
+
+    while (output.size() < triangleCount * 3) {
+        // Best triangle touching the cache; fall back to a linear scan
+        int64_t best = -1;
+        float bestScore = -1.0f;
+
+        for (uint32_t v : cache) {
+            for (uint32_t a = adjacencyOffset[v]; a < adjacencyOffset[v] + remaining[v]; a++) {
+                uint32_t t = adjacency[a];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (best < 0) {
+            while (scanCursor < triangleCount && emitted[scanCursor]) scanCursor++;
+            if (scanCursor == triangleCount) break;
+            best = static_cast<int64_t>(scanCursor);
+        }
+
+        const uint32_t* tri = &indices[static_cast<size_t>(best) * 3];
+        const uint32_t triVerts[3] = { tri[0], tri[1], tri[2] };
+        output.insert(output.end(), triVerts, triVerts + 3);
+        emitted[best] = true;
+
+        // Drop the triangle from its vertices' live adjacency lists
+        for (uint32_t v : triVerts) {
+            uint32_t begin = adjacencyOffset[v];
+            uint32_t end = begin + remaining[v];
+            for (uint32_t a = begin; a < end; a++) {
+                if (adjacency[a] == static_cast<uint32_t>(best)) {
+                    std::swap(adjacency[a], adjacency[end - 1]);
+                    remaining[v]--;
+                    break;
+                }
+            }
+        }
+
+        // New cache: this triangle's vertices first, then the survivors
+        nextCache.assign(triVerts, triVerts + 3);
+        for (uint32_t v : cache) {
+            if (v != triVerts[0] && v != triVerts[1] && v != triVerts[2]) {
+                nextCache.push_back(v);
+            }
+        }
+
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            uint32_t v = nextCache[i];
+            cachePosition[v] = i < forsythCacheSize ? static_cast<int>(i) : -1;
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+
+        // Rescore every live triangle that touches a vertex we just rescored
+        for (uint32_t v : nextCache) {
+            for (uint32_t a = adjacencyOffset[v]; a < adjacencyOffset[v] + remaining[v]; a++) {
+                uint32_t t = adjacency[a];
+                triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+            }
+        }
+
+        if (nextCache.size() > forsythCacheSize) {
+            nextCache.resize(forsythCacheSize);
+        }
+        std::swap(cache, nextCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+size_t kern::optimizeVertexFetch(void* vertices, size_t vertexCount, size_t stride, std::span<uint32_t> indices)
+{
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t next = 0;
+
+    for (uint32_t& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    uint8_t* data = static_cast<uint8_t*>(vertices);
+    std::vector<uint8_t> reordered(size_t(next) * stride);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] != unused) {
+            std::memcpy(reordered.data() + size_t(remap[v]) * stride, data + v * stride, stride);
+        }
+    }
+
+    if (!reordered.empty()) {
+        std::memcpy(data, reordered.data(), reordered.size());
+    }
+    return next;
+}
+
+kern::VertexCacheStats kern::analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize)
+{
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+    if (indices.empty() || cacheSize == 0) return stats;
+
+    // FIFO: a vertex is a hit while fewer than cacheSize misses happened since
+    // it was last transformed
+    std::vector<size_t> timestamp(vertexCount, 0);
+    size_t time = cacheSize + 1;
+
+    for (uint32_t index : indices) {
+        if (time - timestamp[index] > cacheSize) {
+            timestamp[index] = time++;
+            stats.transformed++;
+        }
+    }
+
+    size_t used = 0;
+    {
+        std::vector<bool> seen(vertexCount, false);
+        for (uint32_t index : indices) {
+            if (!seen[index]) {
+                seen[index] = true;
+                used++;
+            }
+        }
+    }
+
+    stats.acmr = stats.triangles ? float(stats.transformed) / float(stats.triangles) : 0.0f;
+    stats.atvr = used ? float(stats.transformed) / float(used) : 0.0f;
+    return stats;
+}
+
+kern::VertexFetchStats kern::analyzeVertexFetch(std::span<const uint32_t> indices, size_t vertexCount, size_t stride)
+{
+    VertexFetchStats stats;
+    if (indices.empty() || vertexCount == 0) return stats;
+
+    // 64 byte lines in a 4 KB direct-mapped cache, roughly a GPU's L1 share
+    constexpr size_t lineSize = 64;
+    constexpr size_t lineCount = 64;
+    size_t lines[lineCount];
+    std::fill(lines, lines + lineCount, ~size_t(0));
+
+    for (uint32_t index : indices) {
+        size_t first = size_t(index) * stride / lineSize;
+        size_t last = (size_t(index) * stride + stride - 1) / lineSize;
+
+        for (size_t line = first; line <= last; line++) {
+            size_t& slot = lines[line % lineCount];
+            if (slot != line) {
+                slot = line;
+                stats.bytesFetched += lineSize;
+            }
+        }
+    }
+
+    stats.overfetch = float(stats.bytesFetched) / float(vertexCount * stride);
+    return stats;
+}
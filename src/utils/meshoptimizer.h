@@ -0,0 +1,99 @@
+// src/utils/meshoptimizer.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace kern {
+
+// Meshes with at most this many vertices are indexed with 16-bit indices
+// (0..0xFFFF), half the index memory and bandwidth of 32-bit ones
+inline constexpr size_t maxShortIndexVertices = 0x10000;
+
+// Post-transform cache behaviour of an index buffer, simulated with a FIFO.
+// ACMR = transformed vertices per triangle (0.5 is ideal for big grids, 3 is
+// unindexed soup), ATVR = transformed vertices per unique vertex (1 is ideal).
+struct VertexCacheStats {
+    size_t triangles = 0;
+    size_t transformed = 0;
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// Bytes pulled through a small cache-line model while fetching vertices.
+// overfetch = fetched bytes / vertex buffer size (1 is ideal).
+struct VertexFetchStats {
+    size_t bytesFetched = 0;
+    float overfetch = 0.0f;
+};
+
+struct MeshOptimizerReport {
+    size_t inputVertices = 0;
+    size_t weldedVertices = 0;
+    VertexCacheStats cacheBefore;  // After welding, original triangle order
+    VertexCacheStats cacheAfter;
+    VertexFetchStats fetchBefore;  // After cache optimization, original vertex order
+    VertexFetchStats fetchAfter;
+};
+
+// Merges byte-identical vertices. Writes the unique vertices (in first use
+// order) to `unique` and returns the index buffer. Vertex types must not
+// contain padding, since padding bytes take part in the comparison.
+std::vector<uint32_t> weldVertices(const void* vertices, size_t count, size_t stride, std::vector<uint8_t>& unique);
+
+// Reorders triangles for post-transform cache locality (Forsyth's
+// linear-speed algorithm), in place
+void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+
+// Reorders vertices in the order the index buffer first touches them and
+// rewrites the indices to match. Unreferenced vertices are dropped; returns
+// the new vertex count.
+size_t optimizeVertexFetch(void* vertices, size_t vertexCount, size_t stride, std::span<uint32_t> indices);
+
+VertexCacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize = 16);
+VertexFetchStats analyzeVertexFetch(std::span<const uint32_t> indices, size_t vertexCount, size_t stride);
+
+template<typename Vertex>
+std::vector<uint32_t> weldVertices(const std::vector<Vertex>& soup, std::vector<Vertex>& unique)
+{
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> indices = weldVertices(soup.data(), soup.size(), sizeof(Vertex), bytes);
+
+    unique.resize(bytes.size() / sizeof(Vertex));
+    if (!bytes.empty()) {
+        std::memcpy(unique.data(), bytes.data(), bytes.size());
+    }
+    return indices;
+}
+
+template<typename Vertex>
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    vertices.resize(optimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices));
+}
+
+// Full pipeline for triangle soup: weld, then cache order, then fetch order
+template<typename Vertex>
+MeshOptimizerReport optimizeMesh(const std::vector<Vertex>& soup, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    MeshOptimizerReport report;
+    report.inputVertices = soup.size();
+
+    indices = weldVertices(soup, vertices);
+    report.weldedVertices = vertices.size();
+    report.cacheBefore = analyzeVertexCache(indices, vertices.size());
+
+    optimizeVertexCache(indices, vertices.size());
+    report.cacheAfter = analyzeVertexCache(indices, vertices.size());
+    report.fetchBefore = analyzeVertexFetch(indices, vertices.size(), sizeof(Vertex));
+
+    optimizeVertexFetch(vertices, indices);
+    report.fetchAfter = analyzeVertexFetch(indices, vertices.size(), sizeof(Vertex));
+
+    return report;
+}
+
+} // namespace kern
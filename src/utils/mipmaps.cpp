@@ -0,0 +1,327 @@
+#include "mipmaps.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KERN_MIPMAPS_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+using kern::MipFilter;
+
+float srgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSRGB(float c)
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+struct SRGBTables {
+    float toLinear[256];
+    uint8_t toSRGB[4096];  // Indexed by linear * 4095
+
+    SRGBTables()
+    {
+        for (int i = 0; i < 256; i++) toLinear[i] = srgbToLinear(i / 255.0f);
+        for (int i = 0; i < 4096; i++) toSRGB[i] = static_cast<uint8_t>(linearToSRGB(i / 4095.0f) * 255.0f + 0.5f);
+    }
+};
+
+const SRGBTables& srgbTables()
+{
+    static const SRGBTables tables;
+    return tables;
+}
+
+// Sum of weighted RGBA texels, one SSE register per texel when available
+struct Accumulator {
+#if KERN_MIPMAPS_SSE
+    __m128 sum = _mm_setzero_ps();
+
+    void add(const float* texel, float weight) { sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(texel), _mm_set1_ps(weight))); }
+    void store(float* out) const { _mm_storeu_ps(out, sum); }
+#else
+    float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    void add(const float* texel, float weight)
+    {
+        for (int c = 0; c < 4; c++) sum[c] += texel[c] * weight;
+    }
+    void store(float* out) const { std::memcpy(out, sum, sizeof(sum)); }
+#endif
+};
+
+// Zeroth-order modified Bessel function of the first kind
+float besselI0(float x)
+{
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 20; k++) {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+    }
+    return sum;
+}
+
+float sinc(float x)
+{
+    if (std::abs(x) < 1e-6f) return 1.0f;
+    const float px = 3.14159265f * x;
+    return std::sin(px) / px;
+}
+
+// One axis of a 2:1 downsample: destination texel x reads source texels
+// scale * x + first + t for every weight t, clamped to the edge
+struct Taps {
+    int scale;
+    int first;
+    std::vector<float> weights;
+};
+
+Taps makeTaps(MipFilter filter, uint32_t sourceSize)
+{
+    if (sourceSize == 1) return { 1, 0, { 1.0f } };
+    if (filter == MipFilter::Box) return { 2, 0, { 0.5f, 0.5f } };
+
+    // Windowed to two destination texels either side of the center
+    constexpr float alpha = 4.0f;
+    constexpr float radius = 2.0f;
+
+    Taps taps{ 2, -3, {} };
+    float total = 0.0f;
+    for (int k = -3; k <= 4; k++) {
+        const float distance = (k - 0.5f) * 0.5f;  // In destination texels
+        const float x = distance / radius;
+        const float weight = sinc(distance) * besselI0(alpha * std::sqrt(std::max(0.0f, 1.0f - x * x))) / besselI0(alpha);
+        taps.weights.push_back(weight);
+        total += weight;
+    }
+    for (float& weight : taps.weights) weight /= total;
+    return taps;
+}
+
+// Rows of a level as premultiplied linear RGBA floats. Level 0 is decoded
+// from the 8-bit source on the fly, later levels are already floats.
+struct Source {
+    const uint8_t* bytes = nullptr;
+    const float* texels = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int channels = 4;
+    bool srgb = true;
+
+    const float* row(uint32_t y, float* scratch) const
+    {
+        if (texels) return texels + size_t(y) * width * 4;
+
+        const float* toLinear = srgbTables().toLinear;
+        const uint8_t* in = bytes + size_t(y) * width * channels;
+        auto color = [&](uint8_t c) { return srgb ? toLinear[c] : c / 255.0f; };
+
+        for (uint32_t x = 0; x < width; x++, in += channels) {
+            float* out = scratch + size_t(x) * 4;
+            if (channels >= 3) {
+                out[0] = color(in[0]);
+                out[1] = color(in[1]);
+                out[2] = color(in[2]);
+            } else {
+                out[0] = out[1] = out[2] = color(in[0]);
+            }
+            out[3] = channels == 4 ? in[3] / 255.0f : channels == 2 ? in[1] / 255.0f : 1.0f;
+
+            out[0] *= out[3];
+            out[1] *= out[3];
+            out[2] *= out[3];
+        }
+        return scratch;
+    }
+};
+
+// Filters destination rows [y0, y1) of the next level into dst
+void filterRows(const Source& source, const Taps& horizontal, const Taps& vertical,
+                float* dst, uint32_t dstWidth, uint32_t y0, uint32_t y1)
+{
+    // Each source row the band touches is filtered horizontally once
+    const int firstRow = vertical.scale * int(y0) + vertical.first;
+    const int lastRow = vertical.scale * int(y1 - 1) + vertical.first + int(vertical.weights.size()) - 1;
+    const size_t rowFloats = size_t(dstWidth) * 4;
+
+    std::vector<float> filtered(size_t(lastRow - firstRow + 1) * rowFloats);
+    std::vector<float> scratch(size_t(source.width) * 4);
+
+    for (int sy = firstRow; sy <= lastRow; sy++) {
+        const uint32_t clampedY = static_cast<uint32_t>(std::clamp(sy, 0, int(source.height) - 1));
+        const float* in = source.row(clampedY, scratch.data());
+        float* out = filtered.data() + size_t(sy - firstRow) * rowFloats;
+
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            Accumulator sum;
+            const int base = horizontal.scale * int(x) + horizontal.first;
+            for (size_t t = 0; t < horizontal.weights.size(); t++) {
+                const int sx = std::clamp(base + int(t), 0, int(source.width) - 1);
+                sum.add(in + size_t(sx) * 4, horizontal.weights[t]);
+            }
+            sum.store(out + size_t(x) * 4);
+        }
+    }
+
+    for (uint32_t y = y0; y < y1; y++) {
+        const int base = vertical.scale * int(y) + vertical.first - firstRow;
+        float* out = dst + size_t(y) * rowFloats;
+
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            Accumulator sum;
+            for (size_t t = 0; t < vertical.weights.size(); t++) {
+                sum.add(filtered.data() + size_t(base + int(t)) * rowFloats + size_t(x) * 4, vertical.weights[t]);
+            }
+            sum.store(out + size_t(x) * 4);
+        }
+    }
+}
+
+// Back from premultiplied linear floats to the source's 8-bit layout
+void encodeRows(const float* texels, uint8_t* dst, uint32_t width, int channels, bool srgb, uint32_t y0, uint32_t y1)
+{
+    const uint8_t* toSRGB = srgbTables().toSRGB;
+    auto color = [&](float c) {
+        c = std::clamp(c, 0.0f, 1.0f);
+        return srgb ? toSRGB[static_cast<int>(c * 4095.0f + 0.5f)] : static_cast<uint8_t>(c * 255.0f + 0.5f);
+    };
+
+    for (uint32_t y = y0; y < y1; y++) {
+        const float* in = texels + size_t(y) * width * 4;
+        uint8_t* out = dst + size_t(y) * width * channels;
+
+        for (uint32_t x = 0; x < width; x++, in += 4, out += channels) {
+            const float alpha = std::clamp(in[3], 0.0f, 1.0f);
+            const float unpremultiply = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+            const uint8_t alphaByte = static_cast<uint8_t>(alpha * 255.0f + 0.5f);
+
+            out[0] = color(in[0] * unpremultiply);
+            if (channels >= 3) {
+                out[1] = color(in[1] * unpremultiply);
+                out[2] = color(in[2] * unpremultiply);
+                if (channels == 4) out[3] = alphaByte;
+            } else if (channels == 2) {
+                out[1] = alphaByte;
+            }
+        }
+    }
+}
+
+// Runs work(y0, y1) over [0, rows), split into bands when there is enough
+// of it to be worth the hand-off. The calling thread claims bands too, and
+// only waits for bands a worker has started: helpers still queued behind
+// other tasks (a burst of async decodes) find nothing left and return.
+void forEachBand(kern::ThreadPool* pool, uint32_t rows, uint32_t rowTexels, const std::function<void(uint32_t, uint32_t)>& work)
+{
+    constexpr size_t minBandTexels = 64 * 1024;
+
+    size_t bands = 1;
+    if (pool) {
+        bands = std::min(pool->getThreadCount() * 2, size_t(rows) * rowTexels / minBandTexels);
+        bands = std::clamp<size_t>(bands, 1, rows);
+    }
+    if (bands == 1) {
+        work(0, rows);
+        return;
+    }
+
+    // Shared, since a late helper may run after this returns
+    struct Bands {
+        const std::function<void(uint32_t, uint32_t)>* work;
+        uint32_t rows;
+        size_t count;
+        std::atomic<size_t> next{ 0 };
+        size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<Bands>();
+    state->work = &work;
+    state->rows = rows;
+    state->count = bands;
+
+    auto run = [](Bands& s) {
+        for (size_t i = s.next++; i < s.count; i = s.next++) {
+            (*s.work)(static_cast<uint32_t>(s.rows * i / s.count), static_cast<uint32_t>(s.rows * (i + 1) / s.count));
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (++s.done == s.count) s.finished.notify_one();
+        }
+    };
+
+    const size_t helpers = std::min(pool->getThreadCount(), bands - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        pool->submit([state, run]() { run(*state); });
+    }
+    run(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == state->count; });
+}
+
+} // namespace
+
+uint32_t kern::getMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) count++;
+    return count;
+}
+
+kern::MipChain kern::generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, int channels,
+                                      const MipOptions& options, ThreadPool* pool)
+{
+    MipChain chain;
+    if (!pixels || width == 0 || height == 0 || channels < 1 || channels > 4) return chain;
+
+    chain.channels = channels;
+    size_t total = 0;
+    const uint32_t levelCount = getMipLevelCount(width, height);
+    for (uint32_t i = 0; i < levelCount; i++) {
+        MipChain::Level level;
+        level.width = std::max(1u, width >> i);
+        level.height = std::max(1u, height >> i);
+        level.offset = total;
+        level.size = size_t(level.width) * level.height * channels;
+        total += level.size;
+        chain.levels.push_back(level);
+    }
+
+    chain.data.resize(total);
+    std::memcpy(chain.data.data(), pixels, chain.levels[0].size);
+
+    Source source{ pixels, nullptr, width, height, channels, options.srgb };
+    std::vector<float> previous, current;
+
+    for (uint32_t i = 1; i < levelCount; i++) {
+        const MipChain::Level& level = chain.levels[i];
+        const Taps horizontal = makeTaps(options.filter, source.width);
+        const Taps vertical = makeTaps(options.filter, source.height);
+
+        current.resize(size_t(level.width) * level.height * 4);
+        uint8_t* out = chain.data.data() + level.offset;
+
+        forEachBand(pool, level.height, level.width, [&](uint32_t y0, uint32_t y1) {
+            filterRows(source, horizontal, vertical, current.data(), level.width, y0, y1);
+            encodeRows(current.data(), out, level.width, channels, options.srgb, y0, y1);
+        });
+
+        // The next level filters these floats, not the rounded bytes
+        previous.swap(current);
+        source = Source{ nullptr, previous.data(), level.width, level.height, channels, options.srgb };
+    }
+
+    return chain;
+}
@@ -0,0 +1,49 @@
+// src/utils/mipmaps.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils/threadpool.h"
+
+namespace kern {
+
+enum class MipFilter : uint8_t {
+    Box,    // 2x2 average
+    Kaiser  // Kaiser-windowed sinc over 8x8 texels, keeps distant detail sharper
+};
+
+struct MipOptions {
+    MipFilter filter = MipFilter::Box;
+    bool srgb = true;  // Color is sRGB encoded, so it is filtered in linear light
+};
+
+// Every level of an 8-bit image, the source as level 0, packed one after
+// another with tight rows (no 4-byte row alignment)
+struct MipChain {
+    struct Level {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        size_t offset = 0;  // Into data
+        size_t size = 0;
+    };
+
+    std::vector<Level> levels;  // Largest first, down to 1x1
+    std::vector<uint8_t> data;
+    int channels = 0;
+
+    bool isValid() const { return !levels.empty(); }
+    const uint8_t* getLevelData(size_t level) const { return data.data() + levels[level].offset; }
+};
+
+uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+// Builds the chain on the CPU for gray, gray + alpha, RGB or RGBA images.
+// Color is weighted by alpha, so fully transparent texels don't bleed into
+// their neighbours. With a pool, large levels are split into row bands that
+// its workers and the calling thread share; a busy pool costs the speedup,
+// never a wait for the pool's other tasks.
+MipChain generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, int channels,
+                          const MipOptions& options = {}, ThreadPool* pool = nullptr);
+
+} // namespace kern
@@ -0,0 +1,168 @@
+#include "polyline.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using kern::Vector2;
+
+constexpr float pi = 3.14159265358979f;
+
+// Below this squared distance (in pixels) two points count as the same
+constexpr float duplicateEpsilon = 1e-8f;
+
+Vector2 perpendicular(Vector2 d, float halfWidth)
+{
+    return { -d.y * halfWidth, d.x * halfWidth };
+}
+
+float cross(Vector2 a, Vector2 b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+float dot(Vector2 a, Vector2 b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+void pushTri(std::vector<Vector2>& out, Vector2 a, Vector2 b, Vector2 c)
+{
+    out.push_back(a);
+    out.push_back(b);
+    out.push_back(c);
+}
+
+// Enough segments that no chord strays more than a quarter pixel from the arc
+int arcSteps(float angle, float radius)
+{
+    const float step = radius > 0.125f ? 2.0f * std::acos(1.0f - 0.25f / radius) : pi;
+    return std::clamp(static_cast<int>(std::ceil(angle / step)), 1, 64);
+}
+
+// Triangle fan around `center`, sweeping `from` by `angle` radians
+void pushArc(std::vector<Vector2>& out, Vector2 center, Vector2 from, float angle, float radius)
+{
+    const int steps = arcSteps(std::abs(angle), radius);
+    const float c = std::cos(angle / steps);
+    const float s = std::sin(angle / steps);
+
+    Vector2 v = from;
+    for (int i = 0; i < steps; i++) {
+        const Vector2 next{ v.x * c - v.y * s, v.x * s + v.y * c };
+        pushTri(out, center, center + v, center + next);
+        v = next;
+    }
+}
+
+// Fills the wedge on the outside of the corner; the inside is already
+// covered by the overlapping segment quads
+void pushJoin(std::vector<Vector2>& out, Vector2 center, Vector2 dirIn, Vector2 dirOut,
+              float halfWidth, const kern::PolylineStyle& style)
+{
+    const float turn = cross(dirIn, dirOut);
+    if (std::abs(turn) < 1e-6f && dot(dirIn, dirOut) > 0.0f) return;  // Straight
+
+    // A left turn opens up on the right side and vice versa
+    const float side = turn > 0.0f ? -1.0f : 1.0f;
+    const Vector2 outerIn = perpendicular(dirIn, halfWidth * side);
+    const Vector2 outerOut = perpendicular(dirOut, halfWidth * side);
+
+    if (style.join == kern::LineJoin::Round) {
+        const float angle = std::atan2(cross(outerIn, outerOut), dot(outerIn, outerOut));
+        pushArc(out, center, outerIn, angle, halfWidth);
+        return;
+    }
+
+    if (style.join == kern::LineJoin::Miter) {
+        const Vector2 sum = outerIn + outerOut;
+        const float sumLength = std::sqrt(dot(sum, sum));
+
+        if (sumLength > 1e-6f * halfWidth) {
+            const Vector2 miter = sum / sumLength;
+            const float cosHalfAngle = dot(miter, outerIn) / halfWidth;
+            const float miterLength = halfWidth / cosHalfAngle;
+
+            if (miterLength <= style.miterLimit * halfWidth) {
+                const Vector2 tip = center + miter * miterLength;
+                pushTri(out, center, center + outerIn, tip);
+                pushTri(out, center, tip, center + outerOut);
+                return;
+            }
+        }
+    }
+
+    pushTri(out, center, center + outerIn, center + outerOut);
+}
+
+} // namespace
+
+void kern::expandPolyline(std::span<const Vector2> points, float width, const PolylineStyle& style,
+                          Vector2 pixelsPerUnit, std::vector<Vector2>& triangles)
+{
+    if (points.size() < 2 || width <= 0.0f || pixelsPerUnit.x <= 0.0f || pixelsPerUnit.y <= 0.0f) return;
+
+    // Expand in pixel space, where the width is uniform in both directions
+    std::vector<Vector2> path;
+    path.reserve(points.size());
+    for (const Vector2& point : points) {
+        const Vector2 p{ point.x * pixelsPerUnit.x, point.y * pixelsPerUnit.y };
+        const Vector2 delta = path.empty() ? Vector2{ 1.0f, 0.0f } : p - path.back();
+        if (dot(delta, delta) > duplicateEpsilon) path.push_back(p);
+    }
+
+    bool closed = style.closed;
+    if (closed && path.size() > 2) {
+        const Vector2 delta = path.back() - path.front();
+        if (dot(delta, delta) <= duplicateEpsilon) path.pop_back();
+    }
+    if (path.size() < 2) return;
+    if (path.size() < 3) closed = false;
+
+    const size_t count = path.size();
+    const size_t segments = closed ? count : count - 1;
+    const float halfWidth = width * 0.5f;
+
+    std::vector<Vector2> directions(segments);
+    for (size_t i = 0; i < segments; i++) {
+        const Vector2 d = path[(i + 1) % count] - path[i];
+        directions[i] = d / std::sqrt(dot(d, d));
+    }
+
+    const size_t first = triangles.size();
+    triangles.reserve(first + segments * 12);
+
+    for (size_t i = 0; i < segments; i++) {
+        const Vector2 d = directions[i];
+        const Vector2 n = perpendicular(d, halfWidth);
+        Vector2 a = path[i];
+        Vector2 b = path[(i + 1) % count];
+
+        if (!closed && style.cap == LineCap::Square) {
+            if (i == 0) a = a - d * halfWidth;
+            if (i == segments - 1) b = b + d * halfWidth;
+        }
+
+        pushTri(triangles, a + n, a - n, b - n);
+        pushTri(triangles, b - n, b + n, a + n);
+    }
+
+    // Join j sits between segment j - 1 and segment j
+    for (size_t j = closed ? 0 : 1; j < (closed ? count : count - 1); j++) {
+        pushJoin(triangles, path[j], directions[(j + segments - 1) % segments], directions[j], halfWidth, style);
+    }
+
+    if (!closed && style.cap == LineCap::Round) {
+        const Vector2 start = directions.front();
+        const Vector2 end = directions.back();
+        pushArc(triangles, path.front(), perpendicular(start, halfWidth), pi, halfWidth);
+        pushArc(triangles, path.back(), perpendicular(end, -halfWidth), pi, halfWidth);
+    }
+
+    const Vector2 unitsPerPixel{ 1.0f / pixelsPerUnit.x, 1.0f / pixelsPerUnit.y };
+    for (size_t i = first; i < triangles.size(); i++) {
+        triangles[i].x *= unitsPerPixel.x;
+        triangles[i].y *= unitsPerPixel.y;
+    }
+}
@@ -0,0 +1,37 @@
+// src/utils/polyline.h
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "utils/vectors.h"
+
+namespace kern {
+
+enum class LineJoin : uint8_t {
+    Miter,  // Sharp corner, falls back to Bevel past miterLimit
+    Bevel,
+    Round
+};
+
+enum class LineCap : uint8_t {
+    Butt,    // Ends exactly at the end points
+    Square,  // Extends half the width past them
+    Round
+};
+
+struct PolylineStyle {
+    LineJoin join = LineJoin::Miter;
+    LineCap cap = LineCap::Butt;
+    float miterLimit = 4.0f;  // Max miter length, in multiples of half the width
+    bool closed = false;      // Connects the last point back to the first
+};
+
+// Expands a polyline into a triangle list (three positions per triangle) and
+// appends it to `triangles`. Points are in NDC; `pixelsPerUnit` is half the
+// viewport size, so the width is in pixels and stays the same at any window
+// size or aspect ratio. Consecutive duplicate points are skipped.
+void expandPolyline(std::span<const Vector2> points, float width, const PolylineStyle& style,
+                    Vector2 pixelsPerUnit, std::vector<Vector2>& triangles);
+
+} // namespace kern
@@ -0,0 +1,63 @@
+// src/utils/radixsort.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace kern {
+
+// Stable LSD radix sort on a 64-bit key, one byte per pass. All eight
+// histograms are built in a single read of the input, and passes where every
+// key shares the same byte are skipped, so keys that only use a few bits
+// cost only a few passes. `scratch` is resized as needed and can be kept
+// around to avoid reallocating every frame.
+template<typename T, typename KeyFn>
+void radixSort(std::vector<T>& items, std::vector<T>& scratch, KeyFn key)
+{
+    const size_t count = items.size();
+    if (count < 2) return;
+
+    constexpr int passes = 8;
+    size_t histograms[passes][256] = {};
+
+    for (const T& item : items) {
+        const uint64_t k = key(item);
+        for (int pass = 0; pass < passes; pass++) {
+            histograms[pass][(k >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch.resize(count);
+    std::vector<T>* src = &items;
+    std::vector<T>* dst = &scratch;
+
+    for (int pass = 0; pass < passes; pass++) {
+        size_t* histogram = histograms[pass];
+
+        // Every key has the same byte here, this pass wouldn't move anything
+        const uint8_t firstByte = static_cast<uint8_t>((key((*src)[0]) >> (pass * 8)) & 0xFF);
+        if (histogram[firstByte] == count) continue;
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            const size_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (const T& item : *src) {
+            const uint8_t byte = static_cast<uint8_t>((key(item) >> (pass * 8)) & 0xFF);
+            (*dst)[histogram[byte]++] = item;
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != &items) {
+        items.swap(scratch);
+    }
+}
+
+} // namespace kern
@@ -0,0 +1,89 @@
+#include "renderqueue.h"
+#include "radixsort.h"
+#include "shaders.h"
+#include "textures.h"
+
+#include <cstring>
+
+namespace {
+
+// Top 23 bits of a non-negative float; IEEE order matches integer order there
+uint64_t quantizeDepth(float depth)
+{
+    if (!(depth > 0.0f)) return 0;
+
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits >> 8;
+}
+
+template<typename Id>
+void countChanges(size_t& changes, Id& current, Id next)
+{
+    if (next != current) {
+        changes++;
+        current = next;
+    }
+}
+
+} // namespace
+
+uint64_t kern::RenderQueue::makeKey(const DrawCommand& command)
+{
+    constexpr uint64_t depthMask = (1ull << 23) - 1;
+
+    const uint64_t program = command.shader ? (command.shader->getId() & 0xFFFF) : 0;
+    const uint64_t texture = command.texture ? (command.texture->getID() & 0xFFFF) : 0;
+    const uint64_t depth = quantizeDepth(command.depth) & depthMask;
+
+    uint64_t key = uint64_t(command.layer) << 56;
+
+    if (command.transparent) {
+        key |= 1ull << 55;
+        key |= (~depth & depthMask) << 32;
+        key |= program << 16;
+        key |= texture;
+    } else {
+        key |= program << 39;
+        key |= texture << 23;
+        key |= depth;
+    }
+    return key;
+}
+
+void kern::RenderQueue::submit(const DrawCommand& command)
+{
+    if (!command.mesh || !command.shader) return;
+
+    order.push_back({ makeKey(command), static_cast<uint32_t>(commands.size()) });
+    commands.push_back(command);
+}
+
+void kern::RenderQueue::sort()
+{
+    stats = {};
+    stats.commands = commands.size();
+
+    GLuint program = 0;
+    unsigned int texture = 0;
+    for (const DrawCommand& command : commands) {
+        countChanges(stats.programChangesUnsorted, program, command.shader->getId());
+        countChanges(stats.textureChangesUnsorted, texture, command.texture ? command.texture->getID() : 0u);
+    }
+
+    radixSort(order, scratch, [](const Entry& entry) { return entry.key; });
+
+    program = 0;
+    texture = 0;
+    for (const Entry& entry : order) {
+        const DrawCommand& command = commands[entry.index];
+        countChanges(stats.programChanges, program, command.shader->getId());
+        countChanges(stats.textureChanges, texture, command.texture ? command.texture->getID() : 0u);
+    }
+}
+
+void kern::RenderQueue::clear()
+{
+    commands.clear();
+    order.clear();
+}
@@ -0,0 +1,84 @@
+// src/utils/renderqueue.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils/vectors.h"
+#include "kernmath.h"
+
+namespace kern {
+
+class Mesh;
+class Texture;
+class OpenGLShaderProgram;
+
+// One deferred mesh draw. The model matrix goes to the shader's `u_Model`
+// and the texture to its `u_Texture`, when the shader declares them; camera
+// matrices come from the KernFrame block.
+struct DrawCommand {
+    const Mesh* mesh = nullptr;
+    OpenGLShaderProgram* shader = nullptr;
+    const Texture* texture = nullptr;
+    Mat4 model = Mat4(1.0f);
+
+    uint8_t layer = 0;         // Lower layers draw first
+    bool transparent = false;  // Drawn after opaque ones, back to front, blended
+    float depth = 0.0f;        // View distance, only used for ordering
+};
+
+struct RenderQueueStats {
+    size_t commands = 0;
+    // Program / texture switches if the commands ran in submission order...
+    size_t programChangesUnsorted = 0;
+    size_t textureChangesUnsorted = 0;
+    // ...and in sorted order
+    size_t programChanges = 0;
+    size_t textureChanges = 0;
+};
+
+// Collects draw commands over a frame and orders them by a packed 64-bit key,
+// most significant first:
+//
+//   | layer 8 | transparent 1 | opaque:      program 16 | texture 16 | depth 23 |
+//   |         |               | transparent: ~depth 23  | program 16 | texture 16 |
+//
+// Opaque draws are grouped by program then texture and go front to back
+// inside a group; transparent ones go strictly back to front.
+class RenderQueue {
+public:
+    void submit(const DrawCommand& command);
+
+    // Sorts the commands recorded since the last clear() and fills the stats
+    void sort();
+    void clear();
+
+    bool empty() const { return commands.empty(); }
+    size_t size() const { return commands.size(); }
+
+    // Commands in execution order; valid after sort()
+    template<typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        for (const Entry& entry : order) {
+            fn(commands[entry.index]);
+        }
+    }
+
+    const RenderQueueStats& getStats() const { return stats; }
+
+    static uint64_t makeKey(const DrawCommand& command);
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<DrawCommand> commands;
+    std::vector<Entry> order;
+    std::vector<Entry> scratch;
+    RenderQueueStats stats;
+};
+
+} // namespace kern
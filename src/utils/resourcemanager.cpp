@@ -0,0 +1,142 @@
+#include "resourcemanager.h"
+
+#include <filesystem>
+#include "config.h"
+
+namespace {
+
+// FNV-1a, continued from `hash`
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// "./a.png" and "a.png" name the same file
+std::string normalizePath(const std::string& path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+} // namespace
+
+kern::ResourceManager::~ResourceManager()
+{
+    for (TextureHandle handle : textures.getHandles()) textures.remove(handle);
+    for (ShaderHandle handle : shaders.getHandles()) shaders.remove(handle);
+    for (MeshHandle handle : meshes.getHandles()) meshes.remove(handle);
+
+    // The context is going away with us, there is nothing left to wait for
+    pending.clear();
+    for (FrameFence& entry : fences) glDeleteSync(entry.fence);
+}
+
+kern::TextureHandle kern::ResourceManager::loadTexture(const std::string& path, TextureFormat format)
+{
+    const std::string key = "file:" + normalizePath(path) + "#" + std::to_string(static_cast<int>(format));
+    if (TextureHandle handle = reuse<OpenGLTexture2D>(key); handle.isValid()) return handle;
+
+    auto texture = std::make_unique<OpenGLTexture2D>(path, format);
+    if (!texture->getID()) return {};
+    return textures.insert(std::move(texture), key);
+}
+
+kern::TextureHandle kern::ResourceManager::createTexture(uint32_t width, uint32_t height, const uint8_t* pixels)
+{
+    if (!pixels || width == 0 || height == 0) return {};
+
+    const uint64_t hash = hashBytes(pixels, size_t(width) * height * 4);
+    const std::string key = "rgba:" + std::to_string(width) + "x" + std::to_string(height) + ":" + std::to_string(hash);
+    if (TextureHandle handle = reuse<OpenGLTexture2D>(key); handle.isValid()) return handle;
+
+    auto texture = std::make_unique<OpenGLTexture2D>(width, height, pixels);
+    if (!texture->getID()) return {};
+    return textures.insert(std::move(texture), key);
+}
+
+kern::ShaderHandle kern::ResourceManager::loadShader(const std::string& vertexPath, const std::string& fragmentPath)
+{
+    const std::string key = normalizePath(vertexPath) + "|" + normalizePath(fragmentPath);
+    if (ShaderHandle handle = reuse<OpenGLShaderProgram>(key); handle.isValid()) return handle;
+
+    auto shader = std::make_unique<OpenGLShaderProgram>(createShader(vertexPath, fragmentPath));
+    if (!shader->getId()) return {};
+    return shaders.insert(std::move(shader), key);
+}
+
+kern::MeshHandle kern::ResourceManager::createMesh(const void* vertices, size_t vertexCount, size_t stride,
+                                                   const uint32_t* indices, size_t indexCount, const VertexLayout& layout)
+{
+    if (!vertices || vertexCount == 0) return {};
+
+    uint64_t hash = hashBytes(vertices, vertexCount * stride);
+    if (indices) hash = hashBytes(indices, indexCount * sizeof(uint32_t), hash);
+    const size_t layoutHash = layout.getHash();
+    hash = hashBytes(&layoutHash, sizeof(layoutHash), hash);
+
+    // Counts are part of the key so equal bytes split differently don't match
+    const std::string key = std::to_string(vertexCount) + "x" + std::to_string(stride) + "/" +
+                            std::to_string(indexCount) + ":" + std::to_string(hash);
+    if (MeshHandle handle = reuse<Mesh>(key); handle.isValid()) return handle;
+
+    auto mesh = std::make_unique<Mesh>(vertices, vertexCount, stride, indices, indexCount, layout);
+    if (!mesh->isValid()) return {};
+    return meshes.insert(std::move(mesh), key);
+}
+
+void kern::ResourceManager::endFrame()
+{
+    if (releasedThisFrame) {
+        fences.push_back({ frame, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+        releasedThisFrame = false;
+    }
+    frame++;
+
+    // Fences signal in submission order, so stop at the first busy one
+    uint64_t completed = 0;
+    bool any = false;
+    while (!fences.empty()) {
+        const GLenum status = glClientWaitSync(fences.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+        completed = fences.front().frame;
+        any = true;
+        glDeleteSync(fences.front().fence);
+        fences.pop_front();
+    }
+
+    if (any) destroyRetired(completed);
+}
+
+void kern::ResourceManager::collect()
+{
+    if (pending.empty()) return;
+
+    glFinish();
+    for (FrameFence& entry : fences) glDeleteSync(entry.fence);
+    fences.clear();
+    releasedThisFrame = false;
+    pending.clear();
+}
+
+void kern::ResourceManager::destroyRetired(uint64_t completedFrame)
+{
+    while (!pending.empty() && pending.front().frame <= completedFrame) {
+        pending.pop_front();
+    }
+}
+
+kern::ResourceStats kern::ResourceManager::getStats() const
+{
+    ResourceStats stats;
+    stats.textures = textures.size();
+    stats.shaders = shaders.size();
+    stats.meshes = meshes.size();
+    stats.deduplicated = deduplicated;
+    stats.pendingDeletes = pending.size();
+    return stats;
+}
@@ -0,0 +1,252 @@
+// src/utils/resourcemanager.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "utils/mesh.h"
+#include "utils/shaders.h"
+#include "utils/textures.h"
+
+namespace kern {
+
+// Slot index plus the slot's generation when the handle was made. Once the
+// resource is destroyed the generation moves on, so old handles go stale
+// instead of pointing at whatever reuses the slot.
+template<typename T>
+struct ResourceHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;  // Never 0 for a handle that was handed out
+
+    bool isValid() const { return generation != 0; }
+    bool operator==(const ResourceHandle&) const = default;
+};
+
+using TextureHandle = ResourceHandle<OpenGLTexture2D>;
+using ShaderHandle = ResourceHandle<OpenGLShaderProgram>;
+using MeshHandle = ResourceHandle<Mesh>;
+
+// Slots for one resource type, with a lookup from dedup key to slot
+template<typename T>
+class ResourcePool {
+public:
+    struct Slot {
+        std::unique_ptr<T> resource;  // Heap allocated so pointers survive growth
+        uint32_t generation = 1;
+        uint32_t refs = 0;
+        std::string key;  // Empty when added without one
+    };
+
+    ResourceHandle<T> insert(std::unique_ptr<T> resource, std::string key)
+    {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        Slot& slot = slots[index];
+        slot.resource = std::move(resource);
+        slot.refs = 1;
+        slot.key = std::move(key);
+        if (!slot.key.empty()) byKey[slot.key] = index;
+        return { index, slot.generation };
+    }
+
+    Slot* find(ResourceHandle<T> handle)
+    {
+        if (handle.index >= slots.size()) return nullptr;
+        Slot& slot = slots[handle.index];
+        return slot.resource && slot.generation == handle.generation ? &slot : nullptr;
+    }
+
+    ResourceHandle<T> findKey(const std::string& key) const
+    {
+        auto it = byKey.find(key);
+        if (it == byKey.end()) return {};
+        return { it->second, slots[it->second].generation };
+    }
+
+    // Empties the slot and makes every handle to it stale
+    std::unique_ptr<T> remove(ResourceHandle<T> handle)
+    {
+        Slot& slot = slots[handle.index];
+        if (!slot.key.empty()) byKey.erase(slot.key);
+        slot.key.clear();
+        slot.refs = 0;
+        if (++slot.generation == 0) slot.generation = 1;
+        freeSlots.push_back(handle.index);
+        return std::move(slot.resource);
+    }
+
+    // Handles to every live resource, for tearing the pool down
+    std::vector<ResourceHandle<T>> getHandles() const
+    {
+        std::vector<ResourceHandle<T>> handles;
+        for (uint32_t i = 0; i < slots.size(); i++) {
+            if (slots[i].resource) handles.push_back({ i, slots[i].generation });
+        }
+        return handles;
+    }
+
+    size_t size() const { return slots.size() - freeSlots.size(); }
+
+private:
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<std::string, uint32_t> byKey;
+};
+
+struct ResourceStats {
+    size_t textures = 0;
+    size_t shaders = 0;
+    size_t meshes = 0;
+    size_t deduplicated = 0;    // Loads answered with an existing resource
+    size_t pendingDeletes = 0;  // Released, waiting for the GPU to finish with them
+};
+
+// Owns textures, shaders and meshes behind generational handles. Loading a
+// path that is already loaded, or mesh/pixel data with the same content,
+// hands back the existing resource with one more reference. When the last
+// reference is released the handle goes stale right away, but the GL object
+// is only destroyed once the frames that could still use it have retired
+// (tracked with a fence per frame). GL thread only.
+class ResourceManager {
+public:
+    ResourceManager() = default;
+    ~ResourceManager();
+
+    ResourceManager(const ResourceManager&) = delete;
+    ResourceManager& operator=(const ResourceManager&) = delete;
+
+    // Invalid handles when loading fails; failures aren't cached
+    TextureHandle loadTexture(const std::string& path, TextureFormat format = TextureFormat::Auto);
+    TextureHandle createTexture(uint32_t width, uint32_t height, const uint8_t* pixels);
+    ShaderHandle loadShader(const std::string& vertexPath, const std::string& fragmentPath);
+
+    template<typename Vertex>
+    MeshHandle createMesh(const std::vector<Vertex>& vertices, const VertexLayout& layout = {})
+    {
+        return createMesh(vertices.data(), vertices.size(), sizeof(Vertex), nullptr, 0, layout);
+    }
+
+    template<typename Vertex>
+    MeshHandle createMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const VertexLayout& layout = {})
+    {
+        return createMesh(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size(), layout);
+    }
+
+    // Static meshes only; dynamic ones change content and go through add()
+    MeshHandle createMesh(const void* vertices, size_t vertexCount, size_t stride,
+                          const uint32_t* indices, size_t indexCount, const VertexLayout& layout = {});
+
+    // Takes ownership without deduplication, starting with one reference
+    TextureHandle add(OpenGLTexture2D&& texture) { return textures.insert(std::make_unique<OpenGLTexture2D>(std::move(texture)), {}); }
+    ShaderHandle add(OpenGLShaderProgram&& shader) { return shaders.insert(std::make_unique<OpenGLShaderProgram>(std::move(shader)), {}); }
+    MeshHandle add(Mesh&& mesh) { return meshes.insert(std::make_unique<Mesh>(std::move(mesh)), {}); }
+
+    // nullptr once the handle is stale
+    template<typename T>
+    T* get(ResourceHandle<T> handle)
+    {
+        auto* slot = pool<T>().find(handle);
+        return slot ? slot->resource.get() : nullptr;
+    }
+
+    template<typename T>
+    void acquire(ResourceHandle<T> handle)
+    {
+        if (auto* slot = pool<T>().find(handle)) slot->refs++;
+    }
+
+    template<typename T>
+    void release(ResourceHandle<T> handle)
+    {
+        auto* slot = pool<T>().find(handle);
+        if (!slot || --slot->refs > 0) return;
+        retire(pool<T>().remove(handle));
+    }
+
+    template<typename T>
+    uint32_t getRefCount(ResourceHandle<T> handle)
+    {
+        auto* slot = pool<T>().find(handle);
+        return slot ? slot->refs : 0;
+    }
+
+    // Fences the frame that was just submitted and destroys what earlier
+    // frames released, once their fences have signaled. Never blocks.
+    void endFrame();
+
+    // Waits for the GPU, then destroys everything released so far
+    void collect();
+
+    ResourceStats getStats() const;
+
+private:
+    struct PendingDelete {
+        uint64_t frame;
+        std::shared_ptr<void> object;  // Keeps the typed deleter
+    };
+
+    struct FrameFence {
+        uint64_t frame;
+        GLsync fence;
+    };
+
+    ResourcePool<OpenGLTexture2D> textures;
+    ResourcePool<OpenGLShaderProgram> shaders;
+    ResourcePool<Mesh> meshes;
+
+    std::deque<PendingDelete> pending;
+    std::deque<FrameFence> fences;
+    uint64_t frame = 0;
+    bool releasedThisFrame = false;
+    size_t deduplicated = 0;
+
+    template<typename T>
+    ResourcePool<T>& pool()
+    {
+        if constexpr (std::is_same_v<T, OpenGLTexture2D>) return textures;
+        else if constexpr (std::is_same_v<T, OpenGLShaderProgram>) return shaders;
+        else {
+            static_assert(std::is_same_v<T, Mesh>, "ResourceManager holds textures, shaders and meshes");
+            return meshes;
+        }
+    }
+
+    // Returns the existing resource with one more reference, if any
+    template<typename T>
+    ResourceHandle<T> reuse(const std::string& key)
+    {
+        ResourceHandle<T> handle = pool<T>().findKey(key);
+        if (handle.isValid()) {
+            acquire(handle);
+            deduplicated++;
+        }
+        return handle;
+    }
+
+    template<typename T>
+    void retire(std::unique_ptr<T> object)
+    {
+        pending.push_back({ frame, std::shared_ptr<void>(std::move(object)) });
+        releasedThisFrame = true;
+    }
+
+    void destroyRetired(uint64_t completedFrame);
+};
+
+// Set by the renderer that owns the manager for the current context
+inline ResourceManager* resourceManager = nullptr;
+
+} // namespace kern
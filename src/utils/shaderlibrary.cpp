@@ -0,0 +1,177 @@
+#include "shaderlibrary.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include "config.h"
+#include "utils/files.h"
+#include "kern/builtinshaders.h"
+
+namespace {
+
+constexpr int maxIncludeDepth = 16;
+
+// Matches `#include "name"` or `#include <name>`, with any spacing
+bool parseInclude(const std::string& line, std::string& name)
+{
+    size_t i = line.find_first_not_of(" \t");
+    if (i == std::string::npos || line[i] != '#') return false;
+
+    i = line.find_first_not_of(" \t", i + 1);
+    if (i == std::string::npos || line.compare(i, 7, "include") != 0) return false;
+
+    i = line.find_first_not_of(" \t", i + 7);
+    if (i == std::string::npos || (line[i] != '"' && line[i] != '<')) return false;
+
+    const char close = line[i] == '"' ? '"' : '>';
+    const size_t end = line.find(close, i + 1);
+    if (end == std::string::npos) return false;
+
+    name = line.substr(i + 1, end - i - 1);
+    return true;
+}
+
+// "NAME" or "NAME=VALUE" as a #define line
+std::string defineLine(const std::string& define)
+{
+    const size_t equals = define.find('=');
+    if (equals == std::string::npos) return "#define " + define + " 1\n";
+    return "#define " + define.substr(0, equals) + " " + define.substr(equals + 1) + "\n";
+}
+
+kern::ShaderDefines normalizeDefines(kern::ShaderDefines defines)
+{
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+    return defines;
+}
+
+} // namespace
+
+std::string_view kern::getBuiltinShaderSource(std::string_view name)
+{
+    for (const builtin::EmbeddedShader& shader : builtin::shaders) {
+        if (shader.name == name) return shader.source;
+    }
+    return {};
+}
+
+kern::ShaderLibrary::ShaderLibrary()
+{
+    for (const builtin::EmbeddedShader& shader : builtin::shaders) {
+        sources.emplace(std::string(shader.name), std::string(shader.source));
+    }
+}
+
+void kern::ShaderLibrary::addSource(const std::string& name, std::string source)
+{
+    sources[name] = std::move(source);
+}
+
+bool kern::ShaderLibrary::addFile(const std::string& path, const std::string& name)
+{
+    std::string source = readFile(path);
+    if (source.empty()) {
+        cast("Shader library: can't read '" + path + "'", DebugLevel::Error);
+        return false;
+    }
+
+    addSource(name.empty() ? std::filesystem::path(path).filename().string() : name, std::move(source));
+    return true;
+}
+
+bool kern::ShaderLibrary::expand(const std::string& name, std::string& out, std::vector<std::string>& included, int depth, std::string& error) const
+{
+    if (depth > maxIncludeDepth) {
+        error = "includes nested too deep at '" + name + "'";
+        return false;
+    }
+
+    auto it = sources.find(name);
+    if (it == sources.end()) {
+        error = "'" + name + "' not found";
+        return false;
+    }
+
+    // Like #pragma once: a file included twice only appears the first time
+    if (std::find(included.begin(), included.end(), name) != included.end()) return true;
+    included.push_back(name);
+
+    // Line directives keep compiler errors pointing at the right line; the
+    // second number is the file's index in include order
+    const std::string fileIndex = std::to_string(included.size() - 1);
+    if (depth > 0) out += "#line 1 " + fileIndex + "\n";
+
+    std::istringstream lines(it->second);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+
+        std::string includeName;
+        if (parseInclude(line, includeName)) {
+            if (!expand(includeName, out, included, depth + 1, error)) {
+                error += " (included from '" + name + "':" + std::to_string(lineNumber) + ")";
+                return false;
+            }
+            out += "#line " + std::to_string(lineNumber + 1) + " " + fileIndex + "\n";
+            continue;
+        }
+
+        out += line;
+        out += '\n';
+    }
+    return true;
+}
+
+std::string kern::ShaderLibrary::preprocess(const std::string& name, const ShaderDefines& defines) const
+{
+    std::string expanded;
+    std::vector<std::string> included;
+    std::string error;
+    if (!expand(name, expanded, included, 0, error)) {
+        cast("Shader library: " + error, DebugLevel::Error);
+        return "";
+    }
+
+    std::string defineBlock;
+    for (const std::string& define : defines) defineBlock += defineLine(define);
+    if (defineBlock.empty()) return expanded;
+
+    // #version has to stay the first directive, so the defines go after it
+    size_t insertAt = 0;
+    int nextLine = 1;
+    const size_t version = expanded.find("#version");
+    if (version != std::string::npos) {
+        const size_t lineEnd = expanded.find('\n', version);
+        insertAt = lineEnd == std::string::npos ? expanded.size() : lineEnd + 1;
+        nextLine = 1 + static_cast<int>(std::count(expanded.begin(), expanded.begin() + insertAt, '\n'));
+    }
+
+    expanded.insert(insertAt, defineBlock + "#line " + std::to_string(nextLine) + " 0\n");
+    return expanded;
+}
+
+kern::OpenGLShaderProgram& kern::ShaderLibrary::getProgram(const std::string& vertexName, const std::string& fragmentName, const ShaderDefines& defines)
+{
+    const ShaderDefines normalized = normalizeDefines(defines);
+
+    std::string key = vertexName + "|" + fragmentName;
+    for (const std::string& define : normalized) key += "|" + define;
+
+    auto it = variants.find(key);
+    if (it != variants.end()) return *it->second;
+
+    const std::string vertexSource = preprocess(vertexName, normalized);
+    const std::string fragmentSource = preprocess(fragmentName, normalized);
+
+    std::unique_ptr<OpenGLShaderProgram> program;
+    if (vertexSource.empty() || fragmentSource.empty()) {
+        program = std::make_unique<OpenGLShaderProgram>();
+    } else {
+        cast("Building shader variant '" + key + "'", DebugLevel::Everything);
+        program = std::make_unique<OpenGLShaderProgram>(vertexSource, fragmentSource, vertexName, fragmentName);
+    }
+
+    return *variants.emplace(key, std::move(program)).first->second;
+}
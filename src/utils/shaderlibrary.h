@@ -0,0 +1,63 @@
+// src/utils/shaderlibrary.h
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "utils/shaders.h"
+
+namespace kern {
+
+// Preprocessor symbols picking one variant of a shader, e.g.
+// { "HAS_TEXTURE", "INSTANCED", "MAX_LIGHTS=4" }. Order doesn't matter.
+using ShaderDefines = std::vector<std::string>;
+
+// Shader sources by name, with a small preprocessor on top: `#include
+// "name"` pulls in another registered source (once per program), and the
+// requested defines are inserted right after #version. Programs are only
+// compiled for the define sets actually asked for, then cached by them.
+// GL thread only.
+class ShaderLibrary {
+public:
+    // Starts out with Kern's built-in shaders under their file names, e.g.
+    // "sprite.vert" or "kernframe.glsl" for the KernFrame block
+    ShaderLibrary();
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    // Registers or replaces a source. Variants built earlier keep their old
+    // code until clearVariants().
+    void addSource(const std::string& name, std::string source);
+    // Registers a file under `name`, its file name by default
+    bool addFile(const std::string& path, const std::string& name = "");
+    bool hasSource(const std::string& name) const { return sources.count(name) != 0; }
+
+    // Includes expanded and defines inserted; empty (and logged) on error
+    std::string preprocess(const std::string& name, const ShaderDefines& defines = {}) const;
+
+    // Compiled on the first request for this pair and define set. Failed
+    // variants are cached too (getId() == 0), so they aren't rebuilt per frame.
+    OpenGLShaderProgram& getProgram(const std::string& vertexName, const std::string& fragmentName, const ShaderDefines& defines = {});
+
+    size_t getVariantCount() const { return variants.size(); }
+    // Destroys every cached program; references from getProgram() dangle
+    void clearVariants() { variants.clear(); }
+
+private:
+    std::unordered_map<std::string, std::string> sources;
+    std::unordered_map<std::string, std::unique_ptr<OpenGLShaderProgram>> variants;
+
+    bool expand(const std::string& name, std::string& out, std::vector<std::string>& included, int depth, std::string& error) const;
+};
+
+// Built-in shader text compiled into the library; empty if there's none
+std::string_view getBuiltinShaderSource(std::string_view name);
+
+// Set by the renderer that owns the library for the current context
+inline ShaderLibrary* shaderLibrary = nullptr;
+
+} // namespace kern
@@ -1,18 +1,345 @@
 #include "utils/shaders.h"
 #include "utils/textures.h"
+#include <algorithm>
+
+namespace {
+
+bool isSamplerType(GLenum type)
+{
+    switch (type) {
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_1D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_1D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_BUFFER:
+        case GL_SAMPLER_2D_RECT:
+        case GL_SAMPLER_2D_RECT_SHADOW:
+        case GL_INT_SAMPLER_1D:
+        case GL_INT_SAMPLER_2D:
+        case GL_INT_SAMPLER_3D:
+        case GL_INT_SAMPLER_CUBE:
+        case GL_INT_SAMPLER_1D_ARRAY:
+        case GL_INT_SAMPLER_2D_ARRAY:
+        case GL_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_INT_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D_RECT:
+        case GL_UNSIGNED_INT_SAMPLER_1D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_3D:
+        case GL_UNSIGNED_INT_SAMPLER_CUBE:
+        case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+        case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Bytes one element of a uniform of this type occupies in the shadow buffer
+uint32_t uniformTypeSize(GLenum type)
+{
+    switch (type) {
+        case GL_FLOAT:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_BOOL:
+            return 4;
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_BOOL_VEC2:
+            return 8;
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_BOOL_VEC3:
+            return 12;
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT_VEC4:
+        case GL_BOOL_VEC4:
+        case GL_FLOAT_MAT2:
+            return 16;
+        case GL_FLOAT_MAT2x3:
+        case GL_FLOAT_MAT3x2:
+            return 24;
+        case GL_FLOAT_MAT2x4:
+        case GL_FLOAT_MAT4x2:
+            return 32;
+        case GL_FLOAT_MAT3:
+            return 36;
+        case GL_FLOAT_MAT3x4:
+        case GL_FLOAT_MAT4x3:
+            return 48;
+        case GL_FLOAT_MAT4:
+            return 64;
+        default:
+            return 4; // Samplers and images are set as a single int
+    }
+}
+
+} // namespace
 
 namespace kern {
 
-void OpenGLShaderProgram::setSample2D(const std::string& name, const Texture& texture)
+void OpenGLShaderProgram::submit(const std::string& vertexSource, const std::string& fragmentSource, const std::string& vertexFilepath, const std::string& fragmentFilepath)
+{
+    id = programCache.load(vertexSource, fragmentSource);
+    if (id) {
+        cast("Program loaded from cache with ID: " + std::to_string(id), DebugLevel::Everything);
+        reflectUniforms();
+        bindUniformBlocks();
+        return;
+    }
+
+    pending = std::make_unique<PendingLink>();
+    pending->vertexSource = vertexSource;
+    pending->fragmentSource = fragmentSource;
+    pending->vertexPath = vertexFilepath;
+    pending->fragmentPath = fragmentFilepath;
+    pending->vertexShader = submitShader(vertexSource, GL_VERTEX_SHADER);
+    pending->fragmentShader = submitShader(fragmentSource, GL_FRAGMENT_SHADER);
+
+    id = glCreateProgram();
+    if (!id) {
+        cast("glCreateProgram returned 0", DebugLevel::Error);
+        releasePending();
+        return;
+    }
+
+    // Linked without checking the compiles: a failed shader fails the link
+    // too, and finish() reports whichever went wrong first
+    glAttachShader(id, pending->vertexShader);
+    glAttachShader(id, pending->fragmentShader);
+    if (programCache.isEnabled()) {
+        glExtensions.glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(id);
+}
+
+bool OpenGLShaderProgram::ready() const
+{
+    if (!pending || !glExtensions.parallelShaderCompile) return true;
+
+    GLint complete = GL_FALSE;
+    glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+void OpenGLShaderProgram::finish()
 {
-    bind();
-    texture.bind();
-    GLint loc = glGetUniformLocation(id, name.c_str());
-    if (loc == -1) return; // uniform not found
+    if (!pending) return;
+
+    // Cleared up front, reflection below binds the program
+    std::unique_ptr<PendingLink> link = std::move(pending);
 
-    if (texture.getID() != 0) {
-        glUniform1i(loc, 0); 
+    const bool vertexCompiled = checkShader(link->vertexShader, link->vertexPath);
+    const bool fragmentCompiled = checkShader(link->fragmentShader, link->fragmentPath);
+
+    // Flagged for deletion, they go away with the program
+    glDeleteShader(link->vertexShader);
+    glDeleteShader(link->fragmentShader);
+
+    if (!vertexCompiled || !fragmentCompiled) {
+        cast("Shader compilation failed", DebugLevel::Error);
+        glDeleteProgram(id);
+        id = 0;
+        return;
     }
+
+    GLint success;
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[512];
+        glGetProgramInfoLog(id, 512, nullptr, infoLog);
+        cast("Program link error: " + std::string(infoLog), DebugLevel::Error);
+        glDeleteProgram(id);
+        id = 0;
+        return;
+    }
+
+    cast("Program linked with ID: " + std::to_string(id), DebugLevel::Everything);
+
+    programCache.store(id, link->vertexSource, link->fragmentSource);
+
+    reflectUniforms();
+    bindUniformBlocks();
+
+#if KERN_GL_VALIDATION > 0
+    // Checks against the current GL state, which at link time says little
+    // and costs a driver round trip; debug builds only. Runs once samplers
+    // have their units, and only warns: the state at draw time may differ.
+    glValidateProgram(id);
+    GLint validated;
+    glGetProgramiv(id, GL_VALIDATE_STATUS, &validated);
+    if (!validated) {
+        GLchar log[512];
+        glGetProgramInfoLog(id, 512, nullptr, log);
+        cast("Program validation failed: " + std::string(log), DebugLevel::Warning);
+    }
+#endif
+}
+
+void OpenGLShaderProgram::releasePending()
+{
+    if (!pending) return;
+
+    glDeleteShader(pending->vertexShader);
+    glDeleteShader(pending->fragmentShader);
+    pending.reset();
+}
+
+void OpenGLShaderProgram::reflectUniforms()
+{
+    uniforms.clear();
+    uniformIndices.clear();
+    values.clear();
+
+    GLint count = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::string name(static_cast<size_t>(maxNameLength > 0 ? maxNameLength : 1), '\0');
+    uint32_t offset = 0;
+
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(id, static_cast<GLuint>(i), maxNameLength, &length, &size, &type, name.data());
+
+        UniformInfo info;
+        info.name = name.substr(0, length);
+        info.location = glGetUniformLocation(id, info.name.c_str());
+
+        // Members of uniform blocks have no location and are set through buffers
+        if (info.location == -1) continue;
+
+        info.type = type;
+        info.arraySize = size;
+        info.valueSize = uniformTypeSize(type) * static_cast<uint32_t>(size);
+        info.valueOffset = offset;
+        offset += (info.valueSize + 3) & ~3u;
+
+        const int index = static_cast<int>(uniforms.size());
+        uniformIndices[info.name] = index;
+
+        // Arrays are reported as "name[0]", accept the bare name as well
+        if (info.name.size() > 3 && info.name.compare(info.name.size() - 3, 3, "[0]") == 0) {
+            uniformIndices[info.name.substr(0, info.name.size() - 3)] = index;
+        }
+
+        uniforms.push_back(std::move(info));
+    }
+
+    values.assign(offset, 0);
+    assignTextureUnits();
+
+    cast("Program " + std::to_string(id) + ": " + std::to_string(uniforms.size()) + " active uniforms", DebugLevel::Everything);
+}
+
+void OpenGLShaderProgram::assignTextureUnits()
+{
+    GLint maxUnits = 0;
+    glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+    const int available = std::min(static_cast<int>(OpenGLStateCache::maxTextureUnits), maxUnits);
+
+    // Every sampler (and every element of a sampler array) gets its own unit
+    // for the life of the program, so textures set through it never collide
+    int nextUnit = 0;
+    for (size_t i = 0; i < uniforms.size(); i++) {
+        UniformInfo& info = uniforms[i];
+        if (!isSamplerType(info.type)) continue;
+
+        if (nextUnit + info.arraySize > available) {
+            cast("Program " + std::to_string(id) + ": out of texture units for '" + info.name + "'", DebugLevel::Warning);
+            break;
+        }
+
+        info.textureUnit = nextUnit;
+        std::vector<GLint> units(static_cast<size_t>(info.arraySize));
+        for (GLint element = 0; element < info.arraySize; element++) {
+            units[element] = nextUnit++;
+        }
+
+        if (shadow(UniformHandle{ static_cast<int>(i) }, units.data(), units.size() * sizeof(GLint))) {
+            bind();
+            glUniform1iv(info.location, info.arraySize, units.data());
+        }
+    }
+}
+
+void OpenGLShaderProgram::bindUniformBlocks()
+{
+    GLint count = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxNameLength);
+
+    std::string name(static_cast<size_t>(maxNameLength > 0 ? maxNameLength : 1), '\0');
+
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(id, static_cast<GLuint>(i), maxNameLength, &length, name.data());
+
+        auto it = uniformBlockBindings.find(name.substr(0, length));
+        if (it != uniformBlockBindings.end()) {
+            glUniformBlockBinding(id, static_cast<GLuint>(i), it->second);
+        }
+    }
+}
+
+bool OpenGLShaderProgram::bindUniformBlock(const std::string& name, GLuint binding)
+{
+    if (id == 0) return false;
+
+    GLuint index = glGetUniformBlockIndex(id, name.c_str());
+    if (index == GL_INVALID_INDEX) {
+        cast("Warning: Uniform block '" + name + "' not found or optimized out", DebugLevel::Warning);
+        return false;
+    }
+
+    glUniformBlockBinding(id, index, binding);
+    return true;
+}
+
+void OpenGLShaderProgram::setTexture(UniformHandle handle, const Texture& texture, int arrayIndex)
+{
+    const int unit = getTextureUnit(handle);
+    if (unit < 0) {
+        if (handle.isValid()) {
+            cast("Uniform '" + uniforms[handle.index].name + "' is not a sampler with a texture unit", DebugLevel::Warning);
+        }
+        return;
+    }
+
+    if (arrayIndex < 0 || arrayIndex >= uniforms[handle.index].arraySize) {
+        cast("Sampler index out of range for '" + uniforms[handle.index].name + "'", DebugLevel::Warning);
+        return;
+    }
+
+    texture.bind(static_cast<uint32_t>(unit + arrayIndex));
+}
+
+int OpenGLShaderProgram::getTextureUnit(UniformHandle handle) const
+{
+    if (handle.index < 0 || handle.index >= static_cast<int>(uniforms.size())) return -1;
+    return uniforms[handle.index].textureUnit;
 }
 
 } // namespace kern
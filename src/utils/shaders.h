@@ -4,16 +4,44 @@
 #include <GLFW/glfw3.h>
 #include <string>
 #include <iostream>
+#include <memory>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
 #include "config.h"
 #include "utils/files.h"
 #include "utils/vertexlayout.h"
 #include "utils/textures.h"
+#include "utils/uniformblock.h"
 #include "kernmath.h"
+#include "backends/OpenGL/openglstate.h"
+#include "backends/OpenGL/opengldebug.h"
+#include "backends/OpenGL/openglextensions.h"
+#include "backends/OpenGL/openglprogramcache.h"
 
 namespace kern
 {
     class Texture;
 
+    // Index into a program's uniform table, from Shader::uniform(name)
+    struct UniformHandle
+    {
+        int index = -1;
+        bool isValid() const { return index >= 0; }
+    };
+
+    struct UniformInfo
+    {
+        std::string name;
+        GLint location = -1;
+        GLenum type = 0;
+        GLint arraySize = 1;
+        uint32_t valueOffset = 0;   // Into the program's shadow value buffer
+        uint32_t valueSize = 0;
+        bool hasValue = false;      // False until the first upload
+        int textureUnit = -1;       // Samplers only: unit of element 0, the rest follow
+    };
+
     class Shader
     {
     public:
@@ -29,62 +57,36 @@ namespace kern
         virtual void setMat4(const std::string& name, const Mat4& matrix) = 0;
         virtual void setMat3(const std::string& name, const Mat3& matrix) = 0;
 
+        virtual UniformHandle uniform(const std::string& name) const = 0;
+        virtual void setFloat(UniformHandle handle, float value) = 0;
+        virtual void setVec2(UniformHandle handle, Vector2 value) = 0;
+        virtual void setVec3(UniformHandle handle, Vector3 value) = 0;
+        virtual void setSample2D(UniformHandle handle, const Texture& texture) = 0;
+        virtual void setMat4(UniformHandle handle, const Mat4& matrix) = 0;
+        virtual void setMat3(UniformHandle handle, const Mat3& matrix) = 0;
+
         virtual unsigned int getId() const = 0;
     };
 
     class OpenGLShaderProgram : public Shader
     {
     public:
+        // Compiles and links before returning. Reuses the driver's binary
+        // from kern::programCache when these exact sources were linked
+        // before on this driver.
         OpenGLShaderProgram(const std::string& vertexSource, const std::string& fragmentSource, const std::string& vertexFilepath = "", const std::string& fragmentFilepath = "")
         {
-            GLuint vertexShader = compileShader(vertexSource, GL_VERTEX_SHADER, vertexFilepath);
-            GLuint fragmentShader = compileShader(fragmentSource, GL_FRAGMENT_SHADER, fragmentFilepath);
-
-            if (vertexShader == 0 || fragmentShader == 0)
-            {
-                id = 0;
-                cast("Shader compilation failed", DebugLevel::Error);
-                return;
-            }
-
-            id = glCreateProgram();
-            if (!id) {
-                cast("glCreateProgram returned 0", kern::DebugLevel::Error);
-                return;
-            }
-            glAttachShader(id, vertexShader);
-            glAttachShader(id, fragmentShader);
-            glLinkProgram(id);
-
-            GLint success;
-            glGetProgramiv(id, GL_LINK_STATUS, &success);
-            if (!success)
-            {
-                GLchar infoLog[512];
-                glGetProgramInfoLog(id, 512, nullptr, infoLog);
-                cast("Program link error: " + std::string(infoLog), DebugLevel::Error);
-                glDeleteProgram(id); 
-                id = 0;
-                return;
-            }
-            
-            glValidateProgram(id);
-            GLint validated;
-            glGetProgramiv(id, GL_VALIDATE_STATUS, &validated);
-            if (!validated)
-            {
-                GLchar log[512];
-                glGetProgramInfoLog(id, 512, nullptr, log);
-                cast("Program validation failed: " + std::string(log), DebugLevel::Error);
-                glDeleteProgram(id);
-                id = 0;
-                return;
-            }
-
-            cast("Program linked with ID: " + std::to_string(id), kern::DebugLevel::Everything);
+            submit(vertexSource, fragmentSource, vertexFilepath, fragmentFilepath);
+            finish();
+        }
 
-            glDeleteShader(vertexShader);
-            glDeleteShader(fragmentShader);
+        // Hands the sources to the driver and returns without waiting for
+        // the compile or link; poll ready(), then call finish()
+        static OpenGLShaderProgram compileAsync(const std::string& vertexSource, const std::string& fragmentSource, const std::string& vertexFilepath = "", const std::string& fragmentFilepath = "")
+        {
+            OpenGLShaderProgram program;
+            program.submit(vertexSource, fragmentSource, vertexFilepath, fragmentFilepath);
+            return program;
         }
 
         OpenGLShaderProgram()
@@ -94,9 +96,10 @@ namespace kern
 
         ~OpenGLShaderProgram()
         {
+            releasePending();
             if (id != 0)
             {
-                glDeleteProgram(id);
+                gl::deleteProgram(id);
             }
         }
 
@@ -106,6 +109,10 @@ namespace kern
         OpenGLShaderProgram(OpenGLShaderProgram&& other) noexcept
             : vertexLayout(std::move(other.vertexLayout))
             , id(other.id)
+            , uniforms(std::move(other.uniforms))
+            , uniformIndices(std::move(other.uniformIndices))
+            , values(std::move(other.values))
+            , pending(std::move(other.pending))
         {
             other.id = 0;
         }
@@ -113,93 +120,138 @@ namespace kern
         OpenGLShaderProgram& operator=(OpenGLShaderProgram&& other) noexcept
         {
             if (this != &other) {
-                if (id) glDeleteProgram(id);
+                releasePending();
+                if (id) gl::deleteProgram(id);
                 vertexLayout = std::move(other.vertexLayout);
                 id = other.id;
+                uniforms = std::move(other.uniforms);
+                uniformIndices = std::move(other.uniformIndices);
+                values = std::move(other.values);
+                pending = std::move(other.pending);
                 other.id = 0;
             }
             return *this;
         }
 
+        // True once finish() won't wait on the driver. Never blocks with
+        // KHR_parallel_shader_compile; without it a pending program always
+        // answers true and finish() waits for the compile instead.
+        bool ready() const;
+
+        // Checks the compile and link results and builds the uniform table,
+        // waiting for the driver if needed. Nothing to do unless the program
+        // came from compileAsync().
+        void finish();
+
+        bool isPending() const { return pending != nullptr; }
+
+        // Link status is checked once in finish(), and a failed program
+        // keeps id = 0, so binding needs no queries or error polling
         void bind() const override
         {
-            GLenum error;
-            while ((error = glGetError()) != GL_NO_ERROR) {
-                // Just clear
-            }
-
             if (!id) {
                 cast("Trying to bind shader with id=0!", kern::DebugLevel::Error);
                 return;
             }
-
-            GLint linked = 0;
-            glGetProgramiv(id, GL_LINK_STATUS, &linked);
-            if (linked == GL_FALSE) {
-                cast("Shader program " + std::to_string(id) + " is not linked! Cannot use.", kern::DebugLevel::Error);
+            if (pending) {
+                cast("Trying to bind a shader that is still compiling, call finish() first", kern::DebugLevel::Error);
                 return;
             }
 
-            glUseProgram(id);
+            gl::useProgram(id);
+        }
 
-            GLenum err = glGetError();
-            if (err == GL_INVALID_OPERATION) {
-                cast("glUseProgram: GL_INVALID_OPERATION. Possible reasons: program not linked, or context not current.", DebugLevel::Error);
-            } else if (err != GL_NO_ERROR) {
-                cast("glUseProgram error: " + std::to_string(err) + " with ID: " + std::to_string(id), DebugLevel::Error);
+
+        void unbind() const override
+        {
+            gl::useProgram(0);
+        }
+
+        // Resolved once from the table built at link time; keep the handle
+        // around to skip the name lookup on every set
+        UniformHandle uniform(const std::string& name) const override
+        {
+            UniformHandle handle = findUniform(name);
+            if (!handle.isValid() && id != 0) {
+                cast("Warning: Uniform '" + name + "' not found or optimized out", DebugLevel::Warning);
             }
+            return handle;
+        }
+
+        // Same as uniform(), for optional uniforms: no warning when missing
+        UniformHandle findUniform(const std::string& name) const
+        {
+            auto it = uniformIndices.find(name);
+            return it == uniformIndices.end() ? UniformHandle{} : UniformHandle{ it->second };
         }
 
+        void setFloat(const std::string& name, float value) override { setFloat(uniform(name), value); }
+        void setVec2(const std::string& name, Vector2 value) override { setVec2(uniform(name), value); }
+        void setVec3(const std::string& name, Vector3 value) override { setVec3(uniform(name), value); }
+        void setMat4(const std::string& name, const Mat4& matrix) override { setMat4(uniform(name), matrix); }
+        void setMat3(const std::string& name, const Mat3& matrix) override { setMat3(uniform(name), matrix); }
 
-        void unbind() const override
+        // Values equal to the last upload issue no GL call at all
+        void setFloat(UniformHandle handle, float value) override
         {
-            glUseProgram(0);
+            if (!shadow(handle, &value, sizeof(value))) return;
+            bind();
+            glUniform1f(uniforms[handle.index].location, value);
         }
 
-        void setFloat(const std::string& name, float value) override
+        void setVec2(UniformHandle handle, Vector2 value) override
         {
+            const float v[2] = { value.x, value.y };
+            if (!shadow(handle, v, sizeof(v))) return;
             bind();
-            GLint loc = getLocation(name);
-            glUniform1f(loc, value);
+            glUniform2fv(uniforms[handle.index].location, 1, v);
         }
 
-        void setVec2(const std::string& name, Vector2 value) override
+        void setVec3(UniformHandle handle, Vector3 value) override
         {
+            const float v[3] = { value.x, value.y, value.z };
+            if (!shadow(handle, v, sizeof(v))) return;
             bind();
-            GLint loc = getLocation(name);
-            glUniform2f(loc, value.x, value.y);
+            glUniform3fv(uniforms[handle.index].location, 1, v);
         }
 
-        void setVec3(const std::string& name, Vector3 value) override
+        void setMat4(UniformHandle handle, const Mat4& matrix) override
         {
+            if (!shadow(handle, glm::value_ptr(matrix), sizeof(float) * 16)) return;
             bind();
-            GLint loc = getLocation(name);
-            glUniform3f(loc, value.x, value.y, value.z);
+            glUniformMatrix4fv(uniforms[handle.index].location, 1, GL_FALSE, glm::value_ptr(matrix));
         }
 
-        void setMat4(const std::string& name, const Mat4& matrix) override {
+        void setMat3(UniformHandle handle, const Mat3& matrix) override
+        {
+            if (!shadow(handle, glm::value_ptr(matrix), sizeof(float) * 9)) return;
             bind();
-            GLint loc = getLocation(name);
-            glUniformMatrix4fv(
-                loc,
-                1,
-                GL_FALSE,
-                glm::value_ptr(matrix)
-            );
+            glUniformMatrix3fv(uniforms[handle.index].location, 1, GL_FALSE, glm::value_ptr(matrix));
         }
 
-        void setMat3(const std::string& name, const Mat3& matrix)override {
+        void setInt(UniformHandle handle, int value)
+        {
+            if (!shadow(handle, &value, sizeof(value))) return;
             bind();
-            GLint loc = getLocation(name);
-            glUniformMatrix3fv(
-                loc,
-                1, 
-                GL_FALSE, 
-                glm::value_ptr(matrix)
-            );
+            glUniform1i(uniforms[handle.index].location, value);
         }
 
-        void setSample2D(const std::string& name, const Texture& texture) override;
+        // Samplers get fixed texture units at link time, so setting one only
+        // binds the texture to that sampler's unit. Works for any texture
+        // type, e.g. an OpenGLTexture2DArray for a sampler2DArray.
+        void setSample2D(const std::string& name, const Texture& texture) override { setTexture(uniform(name), texture); }
+        void setSample2D(UniformHandle handle, const Texture& texture) override { setTexture(handle, texture); }
+        void setTexture(const std::string& name, const Texture& texture, int arrayIndex = 0) { setTexture(uniform(name), texture, arrayIndex); }
+        void setTexture(UniformHandle handle, const Texture& texture, int arrayIndex = 0);
+
+        // Texture unit assigned to a sampler uniform, -1 for anything else
+        int getTextureUnit(UniformHandle handle) const;
+
+        const std::vector<UniformInfo>& getUniforms() const { return uniforms; }
+
+        // Points the named block at a binding point; blocks registered in
+        // kern::uniformBlockBindings are bound automatically at link time
+        bool bindUniformBlock(const std::string& name, GLuint binding);
 
         unsigned int getId() const override { return id; }
 
@@ -210,18 +262,47 @@ namespace kern
         VertexLayout vertexLayout;
         GLuint id;
 
-        GLint getLocation(const std::string& name) const
+        // Active uniforms reflected at link time, with the last uploaded value
+        // of each one packed into `values`
+        std::vector<UniformInfo> uniforms;
+        std::unordered_map<std::string, int> uniformIndices;
+        std::vector<uint8_t> values;
+
+        // What finish() still needs after submit() returned
+        struct PendingLink
         {
-            if (id == 0) 
-            {
-                return -1;
-            }
-            GLint loc = glGetUniformLocation(id, name.c_str());
-            if (loc == -1) {
-                cast("Warning: Uniform '" + name + "' not found or optimized out", DebugLevel::Warning);
-                return -1;
+            GLuint vertexShader = 0;
+            GLuint fragmentShader = 0;
+            std::string vertexSource, fragmentSource;
+            std::string vertexPath, fragmentPath;
+        };
+        std::unique_ptr<PendingLink> pending;
+
+        void submit(const std::string& vertexSource, const std::string& fragmentSource, const std::string& vertexFilepath, const std::string& fragmentFilepath);
+        void releasePending();
+
+        void reflectUniforms();
+        void assignTextureUnits();
+        void bindUniformBlocks();
+
+        // Stores `data` as the uniform's current value; false if it's invalid
+        // or already holds exactly these bytes
+        bool shadow(UniformHandle handle, const void* data, size_t size)
+        {
+            if (handle.index < 0 || handle.index >= static_cast<int>(uniforms.size())) return false;
+
+            UniformInfo& info = uniforms[handle.index];
+            if (size > info.valueSize) {
+                cast("Uniform '" + info.name + "' set with a mismatched type", DebugLevel::Warning);
+                return false;
             }
-            return loc;
+
+            uint8_t* value = values.data() + info.valueOffset;
+            if (info.hasValue && std::memcmp(value, data, size) == 0) return false;
+
+            std::memcpy(value, data, size);
+            info.hasValue = true;
+            return true;
         }
 
         std::string getShaderInfoLog(GLuint shader) {
@@ -234,9 +315,10 @@ namespace kern
             return log;
         }
 
-        GLuint compileShader(const std::string& source, GLenum type, const std::string& path)
+        // Starts the compile; the status is only read in checkShader(), so
+        // the driver is free to work on it in the background until then
+        GLuint submitShader(const std::string& source, GLenum type)
         {
-            cast("Compiling shader: '" + path + "'", false);
             GLuint shader = glCreateShader(type);
 
             // Explicitly ensure null termination
@@ -245,6 +327,12 @@ namespace kern
 
             glShaderSource(shader, 1, &src, &length);
             glCompileShader(shader);
+            return shader;
+        }
+
+        bool checkShader(GLuint shader, const std::string& path)
+        {
+            cast("Compiling shader: '" + path + "'", false);
 
             GLint success;
             glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -252,13 +340,11 @@ namespace kern
             {
                 cast(" [FAILED]", DebugLevel::Everything, false);
                 cast("Shader compile error: " + getShaderInfoLog(shader), DebugLevel::Error);
-                glDeleteShader(shader);
-                return 0;
+                return false;
             }
 
             cast(" [OK]", DebugLevel::Everything, false);
-
-            return shader;
+            return true;
         }
     };
 
@@ -278,4 +364,21 @@ namespace kern
 
         return OpenGLShaderProgram(vertexSource, fragmentSource, vertexFilepath, fragmentFilepath);
     }
+
+    // Like createShader, but returns while the driver is still compiling.
+    // Start every program a loading screen needs, then poll ready() on each
+    // and finish() them; with KHR_parallel_shader_compile the compiles run
+    // side by side on the driver's threads instead of one after another.
+    inline OpenGLShaderProgram createShaderAsync(const std::string& vertexFilepath, const std::string& fragmentFilepath)
+    {
+        std::string vertexSource = kern::readFile(vertexFilepath);
+        std::string fragmentSource = kern::readFile(fragmentFilepath);
+
+        if (vertexSource.empty() || fragmentSource.empty()) {
+            cast("Shader source empty", kern::DebugLevel::Error);
+            return OpenGLShaderProgram(); // Invalid, and never pending
+        }
+
+        return OpenGLShaderProgram::compileAsync(vertexSource, fragmentSource, vertexFilepath, fragmentFilepath);
+    }
 }
@@ -0,0 +1,85 @@
+#include "spritebatch.h"
+
+#include <cstring>
+#include "utils/radixsort.h"
+
+namespace {
+
+// Maps a float onto an unsigned int with the same ordering
+uint32_t sortableFloat(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+uint64_t makeKey(const kern::Sprite& sprite)
+{
+    uint64_t key = uint64_t(sprite.layer) << 56;
+    key |= uint64_t(sprite.region.page & 0xFFFF) << 40;
+    key |= uint64_t(~sortableFloat(sprite.depth)) << 8;  // Back to front
+    return key;
+}
+
+uint32_t pageOf(uint64_t key)
+{
+    return static_cast<uint32_t>((key >> 40) & 0xFFFF);
+}
+
+} // namespace
+
+void kern::SpriteBatch::draw(const Sprite& sprite)
+{
+    if (!sprite.region.isValid()) return;
+
+    order.push_back({ makeKey(sprite), static_cast<uint32_t>(sprites.size()) });
+    sprites.push_back({
+        sprite.position.x, sprite.position.y, sprite.size.x * 0.5f, sprite.size.y * 0.5f,
+        sprite.region.uvMin.x, sprite.region.uvMin.y, sprite.region.uvMax.x, sprite.region.uvMax.y,
+        sprite.tint.r, sprite.tint.g, sprite.tint.b, sprite.tint.a,
+        sprite.rotation, { 0.0f, 0.0f, 0.0f }
+    });
+}
+
+void kern::SpriteBatch::draw(const AtlasRegion& region, Vector2 position, Vector2 size, Color tint)
+{
+    Sprite sprite;
+    sprite.region = region;
+    sprite.position = position;
+    sprite.size = size;
+    sprite.tint = tint;
+    draw(sprite);
+}
+
+void kern::SpriteBatch::sort()
+{
+    ranges.clear();
+    if (sprites.empty()) return;
+
+    radixSort(order, scratch, [](const Entry& entry) { return entry.key; });
+
+    sorted.resize(sprites.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        sorted[i] = sprites[order[i].index];
+    }
+
+    // A new range starts whenever the layer or the page changes
+    size_t start = 0;
+    for (size_t i = 1; i <= order.size(); i++) {
+        if (i < order.size() && (order[i].key >> 40) == (order[start].key >> 40)) continue;
+
+        const GLuint texture = atlas->getPageTexture(pageOf(order[start].key));
+        if (texture) {
+            ranges.push_back({ texture, std::span<const SpriteInstance>(sorted.data() + start, i - start) });
+        }
+        start = i;
+    }
+}
+
+void kern::SpriteBatch::clear()
+{
+    sprites.clear();
+    order.clear();
+    sorted.clear();
+    ranges.clear();
+}
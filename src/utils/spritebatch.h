@@ -0,0 +1,80 @@
+// src/utils/spritebatch.h
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glad/glad.h>
+#include "utils/colors.h"
+#include "utils/textureatlas.h"
+#include "utils/vectors.h"
+
+namespace kern {
+
+struct Sprite {
+    AtlasRegion region;
+    Vector2 position;          // Center, in NDC like the other 2D calls
+    Vector2 size;              // Full width and height, in NDC
+    float rotation = 0.0f;     // Radians, counter-clockwise, in pixel space
+    Color tint = Color(1.0f, 1.0f, 1.0f, 1.0f);
+    uint8_t layer = 0;         // Lower layers draw first
+    float depth = 0.0f;        // Within a layer and page, larger depth draws first
+};
+
+// Per-instance data of the built-in sprite shader, one quad each
+struct SpriteInstance {
+    float centerX, centerY, halfWidth, halfHeight;
+    float uvMinX, uvMinY, uvMaxX, uvMaxY;
+    float r, g, b, a;
+    float rotation;
+    float padding[3];
+};
+
+// Collects sprites whose images live in a TextureAtlas and draws them with
+// one instanced draw per atlas page and layer. Sprites are ordered by a
+// 64-bit key with a radix sort:
+//
+//   | layer 8 | page 16 | ~depth 32 | unused 8 |
+//
+// so a layer still draws on top of the layers below it, but inside a layer
+// sprites on different pages don't interleave. Keep sprites that overlap
+// each other on one page, or put them on different layers.
+class SpriteBatch {
+public:
+    // One run of sorted instances that share a page
+    struct Range {
+        GLuint texture;
+        std::span<const SpriteInstance> instances;
+    };
+
+    explicit SpriteBatch(const TextureAtlas& atlas)
+        : atlas(&atlas) {}
+
+    void draw(const Sprite& sprite);
+    void draw(const AtlasRegion& region, Vector2 position, Vector2 size, Color tint = Color(1.0f, 1.0f, 1.0f, 1.0f));
+
+    // Orders the sprites and builds the draw ranges; Window::draw calls this
+    void sort();
+    void clear();
+
+    bool empty() const { return sprites.empty(); }
+    size_t size() const { return sprites.size(); }
+
+    // Valid after sort(), until the next draw() or clear()
+    const std::vector<Range>& getRanges() const { return ranges; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    const TextureAtlas* atlas;
+    std::vector<SpriteInstance> sprites;
+    std::vector<Entry> order;
+    std::vector<Entry> scratch;
+    std::vector<SpriteInstance> sorted;
+    std::vector<Range> ranges;
+};
+
+} // namespace kern
@@ -0,0 +1,82 @@
+// src/utils/spscqueue.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace kern {
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// The blocking push()/pop() sleep on the index they wait for (C++20 atomic
+// wait) instead of spinning. Each side keeps its last view of the other's
+// index and only reloads it, touching the other side's cache line, when the
+// queue looks full or empty. Every push and pop still calls notify_one() on
+// its own index, which is cheap but not free while nobody waits.
+template<typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool tryPush(const T& value)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) return false;
+        }
+
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        tail.notify_one();
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+
+        value = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is full
+    void push(const T& value)
+    {
+        while (!tryPush(value)) {
+            const size_t h = head.load(std::memory_order_acquire);
+            if (tail.load(std::memory_order_relaxed) - h == Capacity) {
+                head.wait(h, std::memory_order_acquire);
+            }
+        }
+    }
+
+    // Blocks while the queue is empty
+    T pop()
+    {
+        T value;
+        while (!tryPop(value)) {
+            const size_t t = tail.load(std::memory_order_acquire);
+            if (head.load(std::memory_order_relaxed) == t) {
+                tail.wait(t, std::memory_order_acquire);
+            }
+        }
+        return value;
+    }
+
+private:
+    // Separate cache lines, so producer and consumer don't false-share. Each
+    // index shares its line with its owner's cached view of the other one.
+    alignas(64) std::atomic<size_t> head{ 0 };
+    size_t cachedTail = 0;  // Consumer only
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    size_t cachedHead = 0;  // Producer only
+    alignas(64) T slots[Capacity];
+};
+
+} // namespace kern
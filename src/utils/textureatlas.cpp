@@ -0,0 +1,298 @@
+#include "textureatlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "config.h"
+#include "utils/textures.h"
+#include "backends/OpenGL/openglstate.h"
+
+namespace {
+
+// Every image carries a border of this many pixels copied from its edges
+constexpr uint32_t border = 1;
+
+// Restores whatever framebuffers were bound before the atlas borrowed them
+struct FramebufferScope {
+    GLint read = 0;
+    GLint draw = 0;
+
+    FramebufferScope()
+    {
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw);
+    }
+
+    ~FramebufferScope()
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(read));
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(draw));
+    }
+};
+
+void blit(int srcX0, int srcY0, int srcX1, int srcY1, int dstX0, int dstY0, int dstX1, int dstY1)
+{
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+} // namespace
+
+kern::TextureAtlas::TextureAtlas(uint32_t pageSize)
+    : pageSize(pageSize)
+{
+}
+
+kern::TextureAtlas::~TextureAtlas()
+{
+    release();
+}
+
+kern::TextureAtlas::TextureAtlas(TextureAtlas&& other) noexcept
+    : pageSize(other.pageSize),
+      pages(std::move(other.pages)),
+      readFramebuffer(other.readFramebuffer),
+      drawFramebuffer(other.drawFramebuffer)
+{
+    other.pages.clear();
+    other.readFramebuffer = 0;
+    other.drawFramebuffer = 0;
+}
+
+kern::TextureAtlas& kern::TextureAtlas::operator=(TextureAtlas&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        pageSize = other.pageSize;
+        pages = std::move(other.pages);
+        readFramebuffer = other.readFramebuffer;
+        drawFramebuffer = other.drawFramebuffer;
+        other.pages.clear();
+        other.readFramebuffer = 0;
+        other.drawFramebuffer = 0;
+    }
+    return *this;
+}
+
+void kern::TextureAtlas::release()
+{
+    for (Page& page : pages) {
+        if (page.texture) gl::deleteTexture(page.texture);
+    }
+    pages.clear();
+
+    if (readFramebuffer) glDeleteFramebuffers(1, &readFramebuffer);
+    if (drawFramebuffer) glDeleteFramebuffers(1, &drawFramebuffer);
+    readFramebuffer = 0;
+    drawFramebuffer = 0;
+}
+
+kern::AtlasRegion kern::TextureAtlas::add(const OpenGLTexture2D& texture)
+{
+    const uint32_t width = texture.getWidth();
+    const uint32_t height = texture.getHeight();
+    if (!texture.getID() || width == 0 || height == 0) return {};
+
+    FramebufferScope scope;
+
+    if (!readFramebuffer) glGenFramebuffers(1, &readFramebuffer);
+    if (!drawFramebuffer) glGenFramebuffers(1, &drawFramebuffer);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.getID(), 0);
+    if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cast("Texture atlas: texture format can't be copied", DebugLevel::Error);
+        return {};
+    }
+
+    uint32_t page, x, y;
+    if (!allocate(width + 2 * border, height + 2 * border, page, x, y)) return {};
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pages[page].texture, 0);
+
+    const int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+    const int w = static_cast<int>(width), h = static_cast<int>(height);
+    blit(0, 0, w, h, x0 + 1, y0 + 1, x0 + 1 + w, y0 + 1 + h);
+
+    // Extrude the edges into the border, reading from the page itself. The
+    // rectangles never overlap, so this is well defined.
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pages[page].texture, 0);
+    blit(x0 + 1, y0 + 1, x0 + 2, y0 + 1 + h, x0, y0 + 1, x0 + 1, y0 + 1 + h);                  // Left
+    blit(x0 + w, y0 + 1, x0 + w + 1, y0 + 1 + h, x0 + w + 1, y0 + 1, x0 + w + 2, y0 + 1 + h);  // Right
+    blit(x0, y0 + 1, x0 + w + 2, y0 + 2, x0, y0, x0 + w + 2, y0 + 1);                          // Bottom, with corners
+    blit(x0, y0 + h, x0 + w + 2, y0 + h + 1, x0, y0 + h + 1, x0 + w + 2, y0 + h + 2);          // Top, with corners
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+    return makeRegion(page, x, y, width, height);
+}
+
+kern::AtlasRegion kern::TextureAtlas::add(const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    if (!pixels || width == 0 || height == 0) return {};
+
+    uint32_t page, x, y;
+    const uint32_t paddedWidth = width + 2 * border;
+    const uint32_t paddedHeight = height + 2 * border;
+    if (!allocate(paddedWidth, paddedHeight, page, x, y)) return {};
+
+    // Build the bordered image on the CPU and upload it in one call
+    std::vector<uint8_t> padded(size_t(paddedWidth) * paddedHeight * 4);
+    for (uint32_t row = 0; row < paddedHeight; row++) {
+        const uint32_t srcRow = std::min(std::max(row, border) - border, height - 1);
+        uint8_t* dst = padded.data() + size_t(row) * paddedWidth * 4;
+        const uint8_t* src = pixels + size_t(srcRow) * width * 4;
+
+        std::memcpy(dst, src, 4);
+        std::memcpy(dst + 4, src, size_t(width) * 4);
+        std::memcpy(dst + size_t(width + 1) * 4, src + size_t(width - 1) * 4, 4);
+    }
+
+    gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    gl::bindTexture(0, GL_TEXTURE_2D, pages[page].texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+
+    return makeRegion(page, x, y, width, height);
+}
+
+kern::AtlasRegion kern::TextureAtlas::add(const std::string& path)
+{
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(1);
+    unsigned char* bytes = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!bytes) {
+        cast("Failed to load texture '" + path + "' into atlas!", DebugLevel::Error);
+        return {};
+    }
+
+    AtlasRegion region = add(bytes, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    stbi_image_free(bytes);
+    return region;
+}
+
+kern::AtlasRegion kern::TextureAtlas::makeRegion(uint32_t page, uint32_t x, uint32_t y, uint32_t width, uint32_t height) const
+{
+    const float scale = 1.0f / static_cast<float>(pageSize);
+
+    AtlasRegion region;
+    region.page = page;
+    region.uvMin = Vector2(float(x + border) * scale, float(y + border) * scale);
+    region.uvMax = Vector2(float(x + border + width) * scale, float(y + border + height) * scale);
+    region.width = width;
+    region.height = height;
+    return region;
+}
+
+void kern::TextureAtlas::addPage()
+{
+    Page page;
+    glGenTextures(1, &page.texture);
+    gl::bindTexture(0, GL_TEXTURE_2D, page.texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, pageSize, pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    page.skyline.push_back({ 0, 0, pageSize });
+    pages.push_back(std::move(page));
+
+    cast("Texture atlas: page " + std::to_string(pages.size()) + " (" + std::to_string(pageSize) + "x" + std::to_string(pageSize) + ")", DebugLevel::Everything);
+}
+
+bool kern::TextureAtlas::allocate(uint32_t width, uint32_t height, uint32_t& page, uint32_t& x, uint32_t& y)
+{
+    if (width > pageSize || height > pageSize) {
+        cast("Texture atlas: " + std::to_string(width) + "x" + std::to_string(height) + " image doesn't fit a page", DebugLevel::Error);
+        return false;
+    }
+
+    // Earlier pages first, so they fill up before new ones are opened
+    for (uint32_t p = 0; p <= pages.size(); p++) {
+        if (p == pages.size()) addPage();
+
+        Page& candidate = pages[p];
+        size_t bestNode = candidate.skyline.size();
+        uint32_t bestTop = std::numeric_limits<uint32_t>::max();
+        uint32_t bestWidth = std::numeric_limits<uint32_t>::max();
+        uint32_t bestY = 0;
+
+        // Lowest resulting top edge wins, the narrower ledge breaks ties
+        for (size_t node = 0; node < candidate.skyline.size(); node++) {
+            uint32_t nodeY;
+            if (!fit(candidate, node, width, height, nodeY)) continue;
+
+            const uint32_t top = nodeY + height;
+            if (top < bestTop || (top == bestTop && candidate.skyline[node].width < bestWidth)) {
+                bestNode = node;
+                bestTop = top;
+                bestWidth = candidate.skyline[node].width;
+                bestY = nodeY;
+            }
+        }
+
+        if (bestNode != candidate.skyline.size()) {
+            page = p;
+            x = candidate.skyline[bestNode].x;
+            y = bestY;
+            place(candidate, bestNode, x, y, width, height);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool kern::TextureAtlas::fit(const Page& page, size_t node, uint32_t width, uint32_t height, uint32_t& y) const
+{
+    const std::vector<SkylineNode>& skyline = page.skyline;
+    if (skyline[node].x + width > pageSize) return false;
+
+    // The rectangle rests on the highest node it spans
+    y = 0;
+    uint32_t covered = 0;
+    for (size_t i = node; i < skyline.size() && covered < width; i++) {
+        y = std::max(y, skyline[i].y);
+        if (y + height > pageSize) return false;
+        covered += skyline[i].width;
+    }
+    return covered >= width;
+}
+
+void kern::TextureAtlas::place(Page& page, size_t node, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    std::vector<SkylineNode>& skyline = page.skyline;
+    skyline.insert(skyline.begin() + node, { x, y + height, width });
+
+    // Trim or drop the nodes now hidden under the new one
+    const uint32_t right = x + width;
+    for (size_t i = node + 1; i < skyline.size();) {
+        SkylineNode& next = skyline[i];
+        if (next.x >= right) break;
+
+        const uint32_t overlap = right - next.x;
+        if (overlap >= next.width) {
+            skyline.erase(skyline.begin() + i);
+            continue;
+        }
+        next.x += overlap;
+        next.width -= overlap;
+        break;
+    }
+
+    // Merge neighbours at the same height
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+// src/utils/textureatlas.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "utils/vectors.h"
+
+namespace kern {
+
+class OpenGLTexture2D;
+
+// Where an image ended up inside an atlas
+struct AtlasRegion {
+    uint32_t page = 0;
+    Vector2 uvMin;  // Bottom-left, in the page's texture coordinates
+    Vector2 uvMax;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool isValid() const { return width > 0 && height > 0; }
+};
+
+// Packs many small images into a few large RGBA8 pages at runtime, so
+// sprites that use different images can still share one draw. Each page is
+// filled with a skyline bottom-left packer. Images get a one pixel border
+// copied from their own edges, so linear filtering never samples a
+// neighbour. Pages have no mipmaps.
+class TextureAtlas {
+public:
+    explicit TextureAtlas(uint32_t pageSize = 2048);
+    ~TextureAtlas();
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+    TextureAtlas(TextureAtlas&& other) noexcept;
+    TextureAtlas& operator=(TextureAtlas&& other) noexcept;
+
+    // Copies an existing texture into the atlas on the GPU (framebuffer blit)
+    AtlasRegion add(const OpenGLTexture2D& texture);
+    // RGBA8 pixels, rows bottom to top like OpenGLTexture2D loads them
+    AtlasRegion add(const uint8_t* pixels, uint32_t width, uint32_t height);
+    AtlasRegion add(const std::string& path);
+
+    size_t getPageCount() const { return pages.size(); }
+    GLuint getPageTexture(uint32_t page) const { return page < pages.size() ? pages[page].texture : 0; }
+    uint32_t getPageSize() const { return pageSize; }
+
+private:
+    struct SkylineNode {
+        uint32_t x, y, width;
+    };
+
+    struct Page {
+        GLuint texture = 0;
+        std::vector<SkylineNode> skyline;
+    };
+
+    uint32_t pageSize;
+    std::vector<Page> pages;
+    GLuint readFramebuffer = 0;
+    GLuint drawFramebuffer = 0;
+
+    // Finds room for a padded rectangle, opening a new page when none fits
+    bool allocate(uint32_t width, uint32_t height, uint32_t& page, uint32_t& x, uint32_t& y);
+    bool fit(const Page& page, size_t node, uint32_t width, uint32_t height, uint32_t& y) const;
+    void place(Page& page, size_t node, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    void addPage();
+    AtlasRegion makeRegion(uint32_t page, uint32_t x, uint32_t y, uint32_t width, uint32_t height) const;
+    void release();
+};
+
+} // namespace kern
@@ -0,0 +1,363 @@
+#include "textureformats.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include "config.h"
+#include "utils/files.h"
+#include "backends/OpenGL/openglextensions.h"
+
+namespace {
+
+using kern::CompressedFormat;
+using kern::CompressedImage;
+
+uint32_t readU32(std::span<const uint8_t> bytes, size_t offset)
+{
+    uint32_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+uint64_t readU64(std::span<const uint8_t> bytes, size_t offset)
+{
+    uint64_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+constexpr uint32_t fourCC(char a, char b, char c, char d)
+{
+    return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+size_t levelSize(CompressedFormat format, uint32_t width, uint32_t height)
+{
+    const size_t blocksX = std::max(1u, (width + 3) / 4);
+    const size_t blocksY = std::max(1u, (height + 3) / 4);
+    return blocksX * blocksY * kern::getCompressedBlockSize(format);
+}
+
+// Lays out `levelCount` tightly packed levels starting at `offset`
+bool buildLevels(CompressedImage& image, uint32_t width, uint32_t height, uint32_t levelCount,
+                 std::span<const uint8_t> file, size_t offset, std::string& error)
+{
+    image.levels.clear();
+    size_t total = 0;
+
+    for (uint32_t i = 0; i < levelCount; i++) {
+        CompressedImage::Level level;
+        level.width = std::max(1u, width >> i);
+        level.height = std::max(1u, height >> i);
+        level.offset = total;
+        level.size = levelSize(image.format, level.width, level.height);
+        total += level.size;
+        image.levels.push_back(level);
+
+        if (level.width == 1 && level.height == 1) break;
+    }
+
+    if (offset + total > file.size()) {
+        error = "file is truncated";
+        image.levels.clear();
+        return false;
+    }
+
+    image.data.assign(file.begin() + offset, file.begin() + offset + total);
+    return true;
+}
+
+} // namespace
+
+size_t kern::getCompressedBlockSize(CompressedFormat format)
+{
+    switch (format) {
+        case CompressedFormat::BC1:
+        case CompressedFormat::BC1A:
+        case CompressedFormat::BC4:
+            return 8;
+        default:
+            return 16;
+    }
+}
+
+GLenum kern::getCompressedInternalFormat(CompressedFormat format, bool srgb)
+{
+    // Without sRGB S3TC the data is sampled as linear, which is too bright but usable
+    const bool useSRGB = srgb && glExtensions.textureCompressionSRGB;
+
+    switch (format) {
+        case CompressedFormat::BC1:
+            if (!glExtensions.textureCompressionS3TC) return 0;
+            return useSRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case CompressedFormat::BC1A:
+            if (!glExtensions.textureCompressionS3TC) return 0;
+            return useSRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case CompressedFormat::BC3:
+            if (!glExtensions.textureCompressionS3TC) return 0;
+            return useSRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case CompressedFormat::BC4:
+            return GL_COMPRESSED_RED_RGTC1;
+        case CompressedFormat::BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        case CompressedFormat::BC7:
+            if (!glExtensions.textureCompressionBPTC) return 0;
+            return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+bool kern::isCompressedTexturePath(const std::string& path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".dds" || extension == ".ktx2";
+}
+
+bool kern::parseDDS(std::span<const uint8_t> file, CompressedImage& image, std::string& error)
+{
+    constexpr size_t headerEnd = 4 + 124;
+    constexpr uint32_t mipMapCountFlag = 0x20000;
+    constexpr uint32_t depthFlag = 0x800000;
+    constexpr uint32_t cubemapCaps = 0x200;
+
+    if (file.size() < headerEnd || readU32(file, 0) != fourCC('D', 'D', 'S', ' ') || readU32(file, 4) != 124) {
+        error = "not a DDS file";
+        return false;
+    }
+
+    const uint32_t flags = readU32(file, 8);
+    const uint32_t height = readU32(file, 12);
+    const uint32_t width = readU32(file, 16);
+    const uint32_t depth = readU32(file, 24);
+    const uint32_t mipCount = (flags & mipMapCountFlag) ? std::max(1u, readU32(file, 28)) : 1u;
+    const uint32_t format = readU32(file, 84);
+    const uint32_t caps2 = readU32(file, 112);
+
+    if ((caps2 & cubemapCaps) || ((flags & depthFlag) && depth > 1)) {
+        error = "only 2D textures are supported";
+        return false;
+    }
+
+    size_t dataOffset = headerEnd;
+    image.srgb = false;
+
+    switch (format) {
+        case fourCC('D', 'X', 'T', '1'): image.format = CompressedFormat::BC1A; break;
+        case fourCC('D', 'X', 'T', '5'): image.format = CompressedFormat::BC3; break;
+        case fourCC('A', 'T', 'I', '1'):
+        case fourCC('B', 'C', '4', 'U'): image.format = CompressedFormat::BC4; break;
+        case fourCC('A', 'T', 'I', '2'):
+        case fourCC('B', 'C', '5', 'U'): image.format = CompressedFormat::BC5; break;
+        case fourCC('D', 'X', '1', '0'):
+        {
+            if (file.size() < headerEnd + 20) {
+                error = "file is truncated";
+                return false;
+            }
+
+            const uint32_t dxgiFormat = readU32(file, headerEnd);
+            const uint32_t dimension = readU32(file, headerEnd + 4);
+            const uint32_t arraySize = readU32(file, headerEnd + 12);
+            if (dimension != 3 || arraySize > 1) {  // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+                error = "only single 2D textures are supported";
+                return false;
+            }
+
+            switch (dxgiFormat) {
+                case 70: case 71: image.format = CompressedFormat::BC1A; break;
+                case 72: image.format = CompressedFormat::BC1A; image.srgb = true; break;
+                case 76: case 77: image.format = CompressedFormat::BC3; break;
+                case 78: image.format = CompressedFormat::BC3; image.srgb = true; break;
+                case 79: case 80: image.format = CompressedFormat::BC4; break;
+                case 82: case 83: image.format = CompressedFormat::BC5; break;
+                case 97: case 98: image.format = CompressedFormat::BC7; break;
+                case 99: image.format = CompressedFormat::BC7; image.srgb = true; break;
+                default:
+                    error = "unsupported DXGI format " + std::to_string(dxgiFormat);
+                    return false;
+            }
+            dataOffset += 20;
+            break;
+        }
+        default:
+            error = "unsupported or uncompressed pixel format";
+            return false;
+    }
+
+    if (width == 0 || height == 0) {
+        error = "empty image";
+        return false;
+    }
+
+    return buildLevels(image, width, height, mipCount, file, dataOffset, error);
+}
+
+bool kern::parseKTX2(std::span<const uint8_t> file, CompressedImage& image, std::string& error)
+{
+    static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    constexpr size_t levelIndexOffset = 80;
+
+    if (file.size() < levelIndexOffset || std::memcmp(file.data(), identifier, sizeof(identifier)) != 0) {
+        error = "not a KTX2 file";
+        return false;
+    }
+
+    const uint32_t vkFormat = readU32(file, 12);
+    const uint32_t width = readU32(file, 20);
+    const uint32_t height = readU32(file, 24);
+    const uint32_t depth = readU32(file, 28);
+    const uint32_t layers = readU32(file, 32);
+    const uint32_t faces = readU32(file, 36);
+    const uint32_t levelCount = std::max(1u, readU32(file, 40));
+    const uint32_t supercompression = readU32(file, 44);
+
+    if (supercompression != 0) {
+        error = "supercompressed (Basis/Zstd) files are not supported";
+        return false;
+    }
+    if (depth > 1 || layers > 1 || faces != 1 || width == 0 || height == 0) {
+        error = "only single 2D textures are supported";
+        return false;
+    }
+    if (levelCount > 32) {
+        error = "too many mip levels";
+        return false;
+    }
+
+    image.srgb = false;
+    switch (vkFormat) {
+        case 131: image.format = CompressedFormat::BC1; break;
+        case 132: image.format = CompressedFormat::BC1; image.srgb = true; break;
+        case 133: image.format = CompressedFormat::BC1A; break;
+        case 134: image.format = CompressedFormat::BC1A; image.srgb = true; break;
+        case 137: image.format = CompressedFormat::BC3; break;
+        case 138: image.format = CompressedFormat::BC3; image.srgb = true; break;
+        case 139: image.format = CompressedFormat::BC4; break;
+        case 141: image.format = CompressedFormat::BC5; break;
+        case 145: image.format = CompressedFormat::BC7; break;
+        case 146: image.format = CompressedFormat::BC7; image.srgb = true; break;
+        default:
+            error = "unsupported VkFormat " + std::to_string(vkFormat);
+            return false;
+    }
+
+    if (file.size() < levelIndexOffset + size_t(levelCount) * 24) {
+        error = "file is truncated";
+        return false;
+    }
+
+    // Levels have their own offsets (smallest is stored first in the file)
+    image.levels.clear();
+    image.data.clear();
+    for (uint32_t i = 0; i < levelCount; i++) {
+        const uint64_t offset = readU64(file, levelIndexOffset + i * 24);
+        const uint64_t length = readU64(file, levelIndexOffset + i * 24 + 8);
+
+        CompressedImage::Level level;
+        level.width = std::max(1u, width >> i);
+        level.height = std::max(1u, height >> i);
+        level.size = levelSize(image.format, level.width, level.height);
+        level.offset = image.data.size();
+
+        // Offsets come from the file, so offset + size may wrap around
+        if (length < level.size || offset > file.size() || level.size > file.size() - offset) {
+            error = "level " + std::to_string(i) + " is truncated";
+            image.levels.clear();
+            return false;
+        }
+
+        image.data.insert(image.data.end(), file.begin() + offset, file.begin() + offset + level.size);
+        image.levels.push_back(level);
+    }
+    return true;
+}
+
+bool kern::loadCompressedImage(const std::string& path, CompressedImage& image)
+{
+    const std::vector<uint8_t> file = readBinaryFile(path);
+    if (file.empty()) {
+        cast("Failed to read texture '" + path + "'!", DebugLevel::Error);
+        return false;
+    }
+
+    std::string error;
+    const bool ktx2 = file.size() >= 12 && file[0] == 0xAB && file[1] == 'K';
+    const bool parsed = ktx2 ? parseKTX2(file, image, error) : parseDDS(file, image, error);
+    if (!parsed) {
+        cast("Failed to load texture '" + path + "': " + error, DebugLevel::Error);
+        return false;
+    }
+    return true;
+}
+
+kern::ReducedPixels kern::reducePixels(const uint8_t* pixels, uint32_t width, uint32_t height, int channels, TextureFormat target)
+{
+    ReducedPixels result;
+    const size_t count = size_t(width) * height;
+
+    auto red = [&](size_t i) { return pixels[i * channels]; };
+    auto green = [&](size_t i) { return channels >= 3 ? pixels[i * channels + 1] : pixels[i * channels]; };
+    auto blue = [&](size_t i) { return channels >= 3 ? pixels[i * channels + 2] : pixels[i * channels]; };
+    auto alpha = [&](size_t i) -> uint8_t {
+        if (channels == 4) return pixels[i * channels + 3];
+        if (channels == 2) return pixels[i * channels + 1];
+        return 255;
+    };
+    // Rounds an 8-bit value to `bits` bits
+    auto quantize = [](uint8_t value, uint32_t bits) {
+        const uint32_t max = (1u << bits) - 1;
+        return static_cast<uint16_t>((value * max + 127) / 255);
+    };
+
+    if (target == TextureFormat::R8) {
+        result.data.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            // Rec. 709 luma
+            result.data[i] = channels >= 3
+                ? static_cast<uint8_t>((54u * red(i) + 183u * green(i) + 19u * blue(i) + 128u) >> 8)
+                : red(i);
+        }
+        result.internalFormat = GL_R8;
+        result.format = GL_RED;
+        result.type = GL_UNSIGNED_BYTE;
+        result.grayscale = true;
+        return result;
+    }
+
+    result.data.resize(count * 2);
+    uint16_t* out = reinterpret_cast<uint16_t*>(result.data.data());
+
+    for (size_t i = 0; i < count; i++) {
+        switch (target) {
+            case TextureFormat::RGB565:
+                out[i] = static_cast<uint16_t>((quantize(red(i), 5) << 11) | (quantize(green(i), 6) << 5) | quantize(blue(i), 5));
+                break;
+            case TextureFormat::RGBA4:
+                out[i] = static_cast<uint16_t>((quantize(red(i), 4) << 12) | (quantize(green(i), 4) << 8) | (quantize(blue(i), 4) << 4) | quantize(alpha(i), 4));
+                break;
+            default:  // RGB5A1
+                out[i] = static_cast<uint16_t>((quantize(red(i), 5) << 11) | (quantize(green(i), 5) << 6) | (quantize(blue(i), 5) << 1) | (alpha(i) >= 128 ? 1 : 0));
+                break;
+        }
+    }
+
+    switch (target) {
+        case TextureFormat::RGB565:
+            result.internalFormat = glExtensions.rgb565 ? GL_RGB565 : GL_RGB5;
+            result.format = GL_RGB;
+            result.type = GL_UNSIGNED_SHORT_5_6_5;
+            break;
+        case TextureFormat::RGBA4:
+            result.internalFormat = GL_RGBA4;
+            result.format = GL_RGBA;
+            result.type = GL_UNSIGNED_SHORT_4_4_4_4;
+            break;
+        default:
+            result.internalFormat = GL_RGB5_A1;
+            result.format = GL_RGBA;
+            result.type = GL_UNSIGNED_SHORT_5_5_5_1;
+            break;
+    }
+    return result;
+}
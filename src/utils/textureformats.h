@@ -0,0 +1,76 @@
+// src/utils/textureformats.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+namespace kern {
+
+// Storage for textures decoded from PNG/JPEG/... Auto keeps the source's
+// channels at 8 bits; the others trade precision for memory and bandwidth.
+enum class TextureFormat : uint8_t {
+    Auto,    // RGBA8, RGB8, RG8 or R8, like the source
+    R8,      // 8 bits, color is reduced to luminance
+    RGB565,  // 16 bits, alpha dropped
+    RGBA4,   // 16 bits
+    RGB5A1   // 16 bits, alpha thresholded at 50%
+};
+
+enum class CompressedFormat : uint8_t {
+    BC1,   // RGB, 8 bytes per 4x4 block
+    BC1A,  // RGB + 1-bit alpha
+    BC3,   // RGBA, 16 bytes per block
+    BC4,   // R, sampled as gray
+    BC5,   // RG, e.g. normal maps
+    BC7    // RGBA, high quality
+};
+
+// A block-compressed image with its mip chain, as stored in the file.
+// Rows run top to bottom like in the file, unlike the bottom-up images from
+// loadTexture(): flip V when sampling, or export the textures flipped.
+struct CompressedImage {
+    struct Level {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        size_t offset = 0;  // Into data
+        size_t size = 0;
+    };
+
+    CompressedFormat format = CompressedFormat::BC1;
+    bool srgb = false;
+    std::vector<Level> levels;  // Largest first
+    std::vector<uint8_t> data;
+
+    bool isValid() const { return !levels.empty(); }
+    uint32_t getWidth() const { return levels.empty() ? 0 : levels[0].width; }
+    uint32_t getHeight() const { return levels.empty() ? 0 : levels[0].height; }
+};
+
+// DDS (FourCC or DX10 header) and KTX2 (without supercompression) holding
+// BC1/BC3/BC4/BC5/BC7 2D textures. Errors are logged; false on failure.
+bool loadCompressedImage(const std::string& path, CompressedImage& image);
+bool parseDDS(std::span<const uint8_t> file, CompressedImage& image, std::string& error);
+bool parseKTX2(std::span<const uint8_t> file, CompressedImage& image, std::string& error);
+
+bool isCompressedTexturePath(const std::string& path);
+size_t getCompressedBlockSize(CompressedFormat format);
+
+// GL internal format for the current context, 0 if it can't sample it
+GLenum getCompressedInternalFormat(CompressedFormat format, bool srgb);
+
+// 8-bit pixels repacked for one of the reduced formats, ready for glTexImage2D
+struct ReducedPixels {
+    std::vector<uint8_t> data;
+    GLenum internalFormat = 0;
+    GLenum format = 0;
+    GLenum type = 0;
+    bool grayscale = false;  // Single channel, to be swizzled to gray
+};
+
+ReducedPixels reducePixels(const uint8_t* pixels, uint32_t width, uint32_t height, int channels, TextureFormat target);
+
+} // namespace kern
@@ -0,0 +1,138 @@
+#include "textureloader.h"
+
+#include <cstring>
+#include "config.h"
+#include "utils/textures.h"
+#include "backends/OpenGL/openglstate.h"
+
+kern::TextureLoader::TextureLoader(ThreadPool& pool, size_t uploadBudget)
+    : pool(pool), shared(std::make_shared<Shared>()), uploadBudget(uploadBudget)
+{
+}
+
+kern::TextureLoader::~TextureLoader()
+{
+    // Decode tasks still in flight keep `shared` alive and drop their result
+    if (pixelBuffer) gl::deleteBuffer(pixelBuffer);
+}
+
+std::shared_ptr<kern::OpenGLTexture2D> kern::TextureLoader::load(const std::string& path, MipFilter mipFilter)
+{
+    static const uint8_t placeholder[4] = { 128, 128, 128, 255 };
+    auto texture = std::make_shared<OpenGLTexture2D>(1u, 1u, placeholder);
+
+    std::weak_ptr<OpenGLTexture2D> target = texture;
+    std::shared_ptr<Shared> state = shared;
+    state->decoding++;
+
+    pool.submit([state, target, path, mipFilter]() {
+        Decoded image;
+        image.texture = target;
+        image.path = path;
+
+        // Nobody is waiting for it anymore
+        if (!target.expired()) {
+            int width = 0, height = 0, channels = 0;
+            stbi_set_flip_vertically_on_load_thread(1);
+            uint8_t* bytes = stbi_load(path.c_str(), &width, &height, &channels, 4);
+            if (bytes) {
+                // Already on a worker, so the chain is built right here
+                MipOptions options;
+                options.filter = mipFilter;
+                image.mips = generateMipChain(bytes, width, height, 4, options);
+                stbi_image_free(bytes);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->decoded.push_back(std::move(image));
+        state->decoding--;
+    });
+
+    return texture;
+}
+
+void kern::TextureLoader::update()
+{
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        for (Decoded& image : shared->decoded) ready.push_back(std::move(image));
+        shared->decoded.clear();
+    }
+
+    lastStats.uploadedBytes = 0;
+    lastStats.uploadedTextures = 0;
+
+    while (!ready.empty()) {
+        const Decoded& image = ready.front();
+
+        if (image.texture.expired()) {
+            ready.pop_front();
+            continue;
+        }
+        if (!image.mips.isValid()) {
+            cast("Failed to load texture '" + image.path + "'!", DebugLevel::Error);
+            ready.pop_front();
+            continue;
+        }
+
+        const size_t size = image.mips.data.size();
+        if (lastStats.uploadedTextures > 0 && lastStats.uploadedBytes + size > uploadBudget) break;
+
+        if (!upload(image)) break;  // Try again next frame
+        lastStats.uploadedBytes += size;
+        lastStats.uploadedTextures++;
+        ready.pop_front();
+    }
+
+    // Plain glTexImage2D calls elsewhere expect client memory, not a PBO
+    if (lastStats.uploadedTextures > 0) gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+bool kern::TextureLoader::upload(const Decoded& image)
+{
+    std::shared_ptr<OpenGLTexture2D> texture = image.texture.lock();
+    if (!texture || !texture->m_ID) return true;
+
+    const size_t size = image.mips.data.size();
+
+    if (!pixelBuffer) glGenBuffers(1, &pixelBuffer);
+    gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+
+    // Orphan the storage, so the GPU can still be reading the previous
+    // upload while this one is written
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) {
+        cast("Texture upload: failed to map pixel buffer for '" + image.path + "', will retry", DebugLevel::Warning);
+        return false;
+    }
+    std::memcpy(dst, image.mips.data.data(), size);
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+        cast("Texture upload: pixel buffer lost for '" + image.path + "', will retry", DebugLevel::Warning);
+        return false;
+    }
+
+    // Levels are sourced from the bound PBO; the copies run asynchronously
+    gl::bindTexture(0, GL_TEXTURE_2D, texture->m_ID);
+    texture->uploadMipChain(image.mips, nullptr);
+
+    texture->m_Width = static_cast<int>(image.mips.levels[0].width);
+    texture->m_Height = static_cast<int>(image.mips.levels[0].height);
+    texture->m_Channels = 4;
+    return true;
+}
+
+kern::TextureLoaderStats kern::TextureLoader::getStats() const
+{
+    TextureLoaderStats stats = lastStats;
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    stats.pending = ready.size() + shared->decoded.size() + shared->decoding.load();
+    return stats;
+}
+
+std::shared_ptr<kern::OpenGLTexture2D> kern::loadTextureAsync(const std::string& path, MipFilter mipFilter)
+{
+    if (textureLoader) return textureLoader->load(path, mipFilter);
+    return std::make_shared<OpenGLTexture2D>(path, TextureFormat::Auto, mipFilter);
+}
@@ -0,0 +1,83 @@
+// src/utils/textureloader.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "utils/mipmaps.h"
+#include "utils/threadpool.h"
+
+namespace kern {
+
+class OpenGLTexture2D;
+
+struct TextureLoaderStats {
+    size_t pending = 0;          // Still decoding or waiting for upload
+    size_t uploadedBytes = 0;    // In the last update()
+    size_t uploadedTextures = 0;
+};
+
+// Streams textures in without stalling the frame. load() hands back a
+// texture that is usable right away and shows a placeholder; the image is
+// decoded and its mips are filtered on a thread pool, then the whole chain
+// is copied into a pixel buffer object and uploaded from there by update(),
+// at most `uploadBudget` bytes per call.
+// load() and update() must run on the GL thread. Dropping the last handle
+// before the upload cancels it.
+class TextureLoader {
+public:
+    explicit TextureLoader(ThreadPool& pool = defaultThreadPool(), size_t uploadBudget = 8 * 1024 * 1024);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    std::shared_ptr<OpenGLTexture2D> load(const std::string& path, MipFilter mipFilter = MipFilter::Box);
+
+    // Uploads decoded images in load order until the budget is spent. A
+    // single image larger than the budget still goes, alone in its frame.
+    void update();
+
+    void setUploadBudget(size_t bytes) { uploadBudget = bytes; }
+    size_t getUploadBudget() const { return uploadBudget; }
+    TextureLoaderStats getStats() const;
+
+private:
+    struct Decoded {
+        std::weak_ptr<OpenGLTexture2D> texture;
+        std::string path;
+        MipChain mips;  // Empty if decoding failed
+    };
+
+    // Outlives the loader while decode tasks are still running
+    struct Shared {
+        std::mutex mutex;
+        std::vector<Decoded> decoded;
+        std::atomic<size_t> decoding{ 0 };
+    };
+
+    ThreadPool& pool;
+    std::shared_ptr<Shared> shared;
+    std::deque<Decoded> ready;  // Decoded, waiting for budget; GL thread only
+    size_t uploadBudget;
+    GLuint pixelBuffer = 0;
+    TextureLoaderStats lastStats;
+
+    // False when the pixel buffer couldn't be filled; the image stays queued
+    bool upload(const Decoded& image);
+};
+
+// Set by the renderer that owns the loader for the current context
+inline TextureLoader* textureLoader = nullptr;
+
+// Returns a placeholder texture right away and fills it in over the next
+// frames. Loads synchronously when no renderer is alive.
+std::shared_ptr<OpenGLTexture2D> loadTextureAsync(const std::string& path, MipFilter mipFilter = MipFilter::Box);
+
+} // namespace kern
@@ -9,8 +9,12 @@
 #include "utils/vectors.h"
 #include "utils/colors.h"
 #include "utils/shaders.h"
+#include "utils/textureformats.h"
+#include "utils/mipmaps.h"
 #include "utils/vertexlayout.h"
+#include "backends/OpenGL/openglstate.h"
 #include <unordered_map>
+#include <vector>
 
 namespace kern {
 
@@ -38,83 +42,402 @@ public:
 
 class OpenGLTexture2D : public Texture {
 public:
-    OpenGLTexture2D(const std::string& path)
+    // .dds and .ktx2 files are loaded as they are, block compressed with
+    // their own mips; `format` and `mipFilter` apply to everything else
+    OpenGLTexture2D(const std::string& path, TextureFormat format = TextureFormat::Auto, MipFilter mipFilter = MipFilter::Box)
     {
+        if (isCompressedTexturePath(path)) {
+            CompressedImage image;
+            if (loadCompressedImage(path, image)) {
+                createCompressed(image);
+            }
+            return;
+        }
+
         int width, height, channels;
         stbi_set_flip_vertically_on_load(1);
         unsigned char* bytes = stbi_load(path.c_str(), &width, &height, &channels, 0);
         m_Width = width;
         m_Height = height;
+        m_Channels = channels;
         if (!bytes) {
             cast("Failed to load texture!", kern::DebugLevel::Error);
             return;
         }
+        if (channels < 1 || channels > 4) {
+            cast("Unsupported texture format", kern::DebugLevel::Error);
+            stbi_image_free(bytes);
+            return;
+        }
 
         glGenTextures(1, &m_ID);
         bind();
         
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-        GLuint format;
-        if (channels == 4) {
-            format = GL_RGBA;
-        } else if (channels == 3) {
-            format = GL_RGB;
-        }else if (channels == 2) {
-            format = GL_RG;
-        }else if (channels == 1) {
-            format = GL_RED;
+        gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (format == TextureFormat::Auto) {
+            // Mips are filtered on the worker threads; gray images are more
+            // often masks or heights than photos, so they stay linear
+            MipOptions mipOptions;
+            mipOptions.filter = mipFilter;
+            mipOptions.srgb = channels >= 3;
+            MipChain mips = generateMipChain(bytes, m_Width, m_Height, channels, mipOptions, &defaultThreadPool());
+            uploadMipChain(mips, mips.data.data());
+
+            if (channels <= 2) {
+                setGrayscaleSwizzle(channels == 2);
+            }
         } else {
-            cast("Unsupported texture format", kern::DebugLevel::Error);
-            stbi_image_free(bytes);
-            unbind();
-            return;
-        }
+            ReducedPixels reduced = reducePixels(bytes, m_Width, m_Height, channels, format);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, reduced.internalFormat, m_Width, m_Height, 0, reduced.format, reduced.type, reduced.data.data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            m_HasMipmaps = true;
+            applyFilter();
 
-        glTexImage2D(GL_TEXTURE_2D, 0, format, m_Width, m_Height, 0, format, GL_UNSIGNED_BYTE, bytes);
-        glGenerateMipmap(GL_TEXTURE_2D);
+            if (reduced.grayscale) {
+                setGrayscaleSwizzle(false);
+            }
+        }
 
         stbi_image_free(bytes);
         unbind();
     }
+
+    // Uploads every level of the image; nothing is decompressed on the CPU
+    explicit OpenGLTexture2D(const CompressedImage& image)
+    {
+        createCompressed(image);
+    }
+
+    // RGBA8 pixels, rows bottom to top like the path constructor loads them
+    OpenGLTexture2D(uint32_t width, uint32_t height, const uint8_t* pixels)
+        : m_Width(width), m_Height(height), m_Channels(4)
+    {
+        glGenTextures(1, &m_ID);
+        bind();
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        MipChain mips = generateMipChain(pixels, width, height, 4, {}, &defaultThreadPool());
+        if (mips.isValid()) {
+            uploadMipChain(mips, mips.data.data());
+        } else {
+            // No pixels, storage only
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            applyFilter();
+        }
+    }
+
     ~OpenGLTexture2D()
     {
         if (m_ID) {
-            glDeleteTextures(1, &m_ID);
+            gl::deleteTexture(m_ID);
+        }
+    }
+
+    OpenGLTexture2D(const OpenGLTexture2D&) = delete;
+    OpenGLTexture2D& operator=(const OpenGLTexture2D&) = delete;
+
+    OpenGLTexture2D(OpenGLTexture2D&& other) noexcept
+        : m_ID(other.m_ID), m_Width(other.m_Width), m_Height(other.m_Height), m_Channels(other.m_Channels),
+          m_HasMipmaps(other.m_HasMipmaps), m_Filter(other.m_Filter)
+    {
+        other.m_ID = 0;
+    }
+
+    OpenGLTexture2D& operator=(OpenGLTexture2D&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_ID) {
+                gl::deleteTexture(m_ID);
+            }
+            m_ID = other.m_ID;
+            m_Width = other.m_Width;
+            m_Height = other.m_Height;
+            m_Channels = other.m_Channels;
+            m_HasMipmaps = other.m_HasMipmaps;
+            m_Filter = other.m_Filter;
+            other.m_ID = 0;
+        }
+        return *this;
+    }
+
+    void bind(uint32_t slot = 0) const override
+    {
+        if (m_ID) {
+            gl::bindTexture(slot, GL_TEXTURE_2D, m_ID);
+        }
+    }
+
+    void unbind() const override
+    {
+        if (m_ID) {
+            gl::bindTexture(0, GL_TEXTURE_2D, 0);
+        }
+    }
+
+    // Kept across a later upload, like the one replacing an async placeholder
+    void setFilterMode(kern::Filter mode) override
+    {
+        m_Filter = mode;
+        if (m_ID) {
+            gl::bindTexture(0, GL_TEXTURE_2D, m_ID);
+            applyFilter();
+        }
+    }
+
+    uint32_t getWidth() const override { return m_Width; }
+
+    uint32_t getHeight() const override { return m_Height; }
+
+    unsigned int getID() const override { return m_ID; }
+
+private:
+    unsigned int m_ID = 0;
+    int m_Width = 0, m_Height = 0, m_Channels = 0;
+    bool m_HasMipmaps = false;
+    kern::Filter m_Filter = kern::Filter::Linear;
+
+    // Replaces the placeholder once the image is uploaded
+    friend class TextureLoader;
+
+    void createCompressed(const CompressedImage& image)
+    {
+        const GLenum internalFormat = getCompressedInternalFormat(image.format, image.srgb);
+        if (!internalFormat) {
+            cast("Texture: compressed format not supported by this driver", kern::DebugLevel::Error);
+            return;
+        }
+
+        m_Width = static_cast<int>(image.getWidth());
+        m_Height = static_cast<int>(image.getHeight());
+        m_Channels = 4;
+
+        glGenTextures(1, &m_ID);
+        bind();
+
+        m_HasMipmaps = image.levels.size() > 1;
+        applyFilter();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // Files may stop before 1x1; don't let GL expect the missing levels
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size()) - 1);
+
+        gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        for (size_t i = 0; i < image.levels.size(); i++) {
+            const CompressedImage::Level& level = image.levels[i];
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), internalFormat, level.width, level.height, 0,
+                                   static_cast<GLsizei>(level.size), image.data.data() + level.offset);
+        }
+
+        if (image.format == CompressedFormat::BC4) {
+            setGrayscaleSwizzle(false);
+        }
+        unbind();
+    }
+
+    // Copies every level of the chain into the texture, which must be bound.
+    // `base` is the chain's data in client memory, or nullptr when it sits at
+    // offset 0 of the bound pixel unpack buffer.
+    void uploadMipChain(const MipChain& mips, const uint8_t* base)
+    {
+        static const GLenum internalFormats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+        static const GLenum formats[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        const int channels = mips.channels;
+
+        // Rows of RGB and gray images aren't 4-byte aligned in general
+        glPixelStorei(GL_UNPACK_ALIGNMENT, channels == 4 ? 4 : 1);
+        for (size_t i = 0; i < mips.levels.size(); i++) {
+            const MipChain::Level& level = mips.levels[i];
+            const void* data = base ? static_cast<const void*>(base + level.offset) : reinterpret_cast<const void*>(level.offset);
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), internalFormats[channels - 1], level.width, level.height, 0,
+                         formats[channels - 1], GL_UNSIGNED_BYTE, data);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(mips.levels.size()) - 1);
+
+        m_HasMipmaps = mips.levels.size() > 1;
+        applyFilter();
+    }
+
+    // Min filter samples the mips whenever there are any, on the bound texture
+    void applyFilter()
+    {
+        if (m_Filter == kern::Filter::Linear) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_HasMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        } else {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_HasMipmaps ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+    }
+
+    // Single-channel textures read as gray instead of red; two-channel ones
+    // as gray + alpha. Shaders reading .r still get the same value.
+    void setGrayscaleSwizzle(bool withAlpha)
+    {
+        const GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, withAlpha ? GL_GREEN : GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+};
+
+inline OpenGLTexture2D loadTexture(const std::string& path, TextureFormat format = TextureFormat::Auto, MipFilter mipFilter = MipFilter::Box)
+{
+    return OpenGLTexture2D(path, format, mipFilter);
+}
+
+// Same-sized RGBA8 images behind one sampler2DArray. Draws that use
+// different images can share one call when each vertex or instance carries
+// the layer to sample: texture(u_Textures, vec3(uv, layer)).
+class OpenGLTexture2DArray : public Texture {
+public:
+    OpenGLTexture2DArray(uint32_t width, uint32_t height, uint32_t layers)
+        : m_Width(width), m_Height(height), m_Layers(layers)
+    {
+        if (width == 0 || height == 0 || layers == 0) {
+            cast("Texture array needs a non-zero size", kern::DebugLevel::Error);
+            return;
+        }
+
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        if (layers > static_cast<uint32_t>(maxLayers)) {
+            cast("Texture array: " + std::to_string(layers) + " layers, the driver allows " + std::to_string(maxLayers), kern::DebugLevel::Error);
+            return;
+        }
+
+        glGenTextures(1, &m_ID);
+        bind();
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    // Sized after the first image; every other image must match it
+    explicit OpenGLTexture2DArray(const std::vector<std::string>& paths)
+    {
+        for (size_t i = 0; i < paths.size(); i++) {
+            int width, height, channels;
+            stbi_set_flip_vertically_on_load(1);
+            unsigned char* bytes = stbi_load(paths[i].c_str(), &width, &height, &channels, 4);
+            if (!bytes) {
+                cast("Failed to load texture '" + paths[i] + "'!", kern::DebugLevel::Error);
+                continue;
+            }
+
+            if (!m_ID) {
+                *this = OpenGLTexture2DArray(width, height, static_cast<uint32_t>(paths.size()));
+            }
+            setLayer(static_cast<uint32_t>(i), bytes, width, height);
+            stbi_image_free(bytes);
+        }
+
+        if (m_ID) {
+            generateMipmaps();
+        }
+    }
+
+    ~OpenGLTexture2DArray()
+    {
+        if (m_ID) {
+            gl::deleteTexture(m_ID);
         }
     }
 
+    OpenGLTexture2DArray(const OpenGLTexture2DArray&) = delete;
+    OpenGLTexture2DArray& operator=(const OpenGLTexture2DArray&) = delete;
+
+    OpenGLTexture2DArray(OpenGLTexture2DArray&& other) noexcept
+        : m_ID(other.m_ID), m_Width(other.m_Width), m_Height(other.m_Height),
+          m_Layers(other.m_Layers), m_HasMipmaps(other.m_HasMipmaps)
+    {
+        other.m_ID = 0;
+    }
+
+    OpenGLTexture2DArray& operator=(OpenGLTexture2DArray&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_ID) {
+                gl::deleteTexture(m_ID);
+            }
+            m_ID = other.m_ID;
+            m_Width = other.m_Width;
+            m_Height = other.m_Height;
+            m_Layers = other.m_Layers;
+            m_HasMipmaps = other.m_HasMipmaps;
+            other.m_ID = 0;
+        }
+        return *this;
+    }
+
+    // RGBA8 pixels, rows bottom to top like OpenGLTexture2D loads them.
+    // Call generateMipmaps() once all layers are in.
+    bool setLayer(uint32_t layer, const uint8_t* pixels, uint32_t width, uint32_t height)
+    {
+        if (!m_ID || !pixels || layer >= m_Layers) {
+            cast("Texture array: layer " + std::to_string(layer) + " out of range", kern::DebugLevel::Error);
+            return false;
+        }
+        if (width != m_Width || height != m_Height) {
+            cast("Texture array: layer " + std::to_string(layer) + " is " + std::to_string(width) + "x" + std::to_string(height) +
+                 ", expected " + std::to_string(m_Width) + "x" + std::to_string(m_Height), kern::DebugLevel::Error);
+            return false;
+        }
+
+        bind();
+        gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        return true;
+    }
+
+    void generateMipmaps()
+    {
+        if (!m_ID) return;
+
+        bind();
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        m_HasMipmaps = true;
+    }
+
     void bind(uint32_t slot = 0) const override
     {
         if (m_ID) {
-            glActiveTexture(GL_TEXTURE0 + slot);
-            glBindTexture(GL_TEXTURE_2D, m_ID);
+            gl::bindTexture(slot, GL_TEXTURE_2D_ARRAY, m_ID);
         }
     }
 
     void unbind() const override
     {
         if (m_ID) {
-            glBindTexture(GL_TEXTURE_2D, 0);
+            gl::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
         }
     }
 
     void setFilterMode(kern::Filter mode) override
     {
         if (m_ID) {
-            glBindTexture(GL_TEXTURE_2D, m_ID);
+            bind();
             if (mode == kern::Filter::Linear) {
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_HasMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             } else {
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_HasMipmaps ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
             }
-            glBindTexture(GL_TEXTURE_2D, 0);
         }
     }
 
@@ -122,15 +445,18 @@ public:
 
     uint32_t getHeight() const override { return m_Height; }
 
+    uint32_t getLayerCount() const { return m_Layers; }
+
     unsigned int getID() const override { return m_ID; }
 
 private:
-    unsigned int m_ID;
-    int m_Width, m_Height, m_Channels;
+    unsigned int m_ID = 0;
+    uint32_t m_Width = 0, m_Height = 0, m_Layers = 0;
+    bool m_HasMipmaps = false;
 };
 
-inline OpenGLTexture2D loadTexture(const std::string& path)
+inline OpenGLTexture2DArray loadTextureArray(const std::vector<std::string>& paths)
 {
-    return OpenGLTexture2D(path);
+    return OpenGLTexture2DArray(paths);
 }
 }
@@ -0,0 +1,108 @@
+// src/utils/threadpool.h
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kern {
+
+// Fixed set of worker threads pulling tasks from one FIFO queue. Meant for
+// coarse jobs (decoding a file, building a mesh); tasks must not touch GL.
+class ThreadPool {
+public:
+    // 0 picks one thread less than the hardware has, leaving a core for the
+    // main thread, but at least one
+    explicit ThreadPool(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0) {
+            const unsigned int hardware = std::thread::hardware_concurrency();
+            threadCount = std::max(1u, hardware > 1 ? hardware - 1 : 1u);
+        }
+
+        workers.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; i++) {
+            workers.emplace_back([this]() { run(); });
+        }
+    }
+
+    // Finishes the queued tasks, then joins
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task)
+    {
+        if (!task) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        taskReady.notify_one();
+    }
+
+    // Blocks until the queue is empty and no task is running
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return tasks.empty() && running == 0; });
+    }
+
+    size_t getThreadCount() const { return workers.size(); }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable idle;
+    size_t running = 0;
+    bool stopping = false;
+
+    void run()
+    {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                taskReady.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;  // Stopping, and nothing left to do
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                running++;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+                if (tasks.empty() && running == 0) idle.notify_all();
+            }
+        }
+    }
+};
+
+// Shared pool for Kern's own background work, created on first use
+inline ThreadPool& defaultThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace kern
@@ -0,0 +1,150 @@
+// src/utils/uniformblock.h
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include "config.h"
+#include "utils/vectors.h"
+#include "kernmath.h"
+#include "backends/OpenGL/openglstate.h"
+
+// Checks a member's offset against the std140 offset the GLSL block expects
+#define KERN_STD140_OFFSET(Type, member, expected) \
+    static_assert(offsetof(Type, member) == (expected), #Type "::" #member " is not at its std140 offset")
+
+namespace kern
+{
+    // Binding point of the per-frame block, shared by every program
+    constexpr GLuint frameBlockBinding = 0;
+
+    // Block name -> binding point. Programs look their active blocks up here
+    // when they link, so registered blocks need no per-shader setup.
+    inline std::unordered_map<std::string, GLuint> uniformBlockBindings = {
+        { "KernFrame", frameBlockBinding }
+    };
+
+    // Mirrors this GLSL block, filled by the renderer:
+    //
+    //   layout(std140) uniform KernFrame {
+    //       mat4 u_View;
+    //       mat4 u_Projection;
+    //       mat4 u_ViewProjection;
+    //       vec4 u_Viewport;   // x, y, width, height in pixels
+    //       float u_Time;
+    //       float u_DeltaTime;
+    //   };
+    struct FrameConstants
+    {
+        Mat4 view = Mat4(1.0f);
+        Mat4 projection = Mat4(1.0f);
+        Mat4 viewProjection = Mat4(1.0f);
+        float viewport[4] = {};
+        float time = 0.0f;
+        float deltaTime = 0.0f;
+        float padding[2] = {};
+    };
+
+    KERN_STD140_OFFSET(FrameConstants, projection, 64);
+    KERN_STD140_OFFSET(FrameConstants, viewProjection, 128);
+    KERN_STD140_OFFSET(FrameConstants, viewport, 192);
+    KERN_STD140_OFFSET(FrameConstants, time, 208);
+    KERN_STD140_OFFSET(FrameConstants, deltaTime, 212);
+
+    // A UBO holding one T, bound to a fixed binding point. T has to mirror a
+    // std140 block: plain data, vec3s padded to 16 bytes, size a multiple of 16.
+    // Check member offsets with KERN_STD140_OFFSET.
+    template<typename T>
+    class UniformBlock
+    {
+        static_assert(std::is_standard_layout_v<T>, "UniformBlock type must be standard layout");
+        static_assert(std::is_trivially_copyable_v<T>, "UniformBlock type must be trivially copyable");
+        static_assert(sizeof(T) % 16 == 0, "std140 blocks are padded to a multiple of 16 bytes");
+        static_assert(alignof(T) <= 16, "UniformBlock type is over-aligned");
+
+    public:
+        UniformBlock() = default;
+
+        // Registers `name` at `binding` so programs linked from now on pick it up
+        UniformBlock(const std::string& name, GLuint binding)
+            : binding(binding)
+        {
+            glGenBuffers(1, &ubo);
+            if (!ubo) {
+                cast("UniformBlock: failed to generate buffer!", DebugLevel::Error);
+                return;
+            }
+
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ubo);
+            glBufferData(GL_COPY_WRITE_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+            uniformBlockBindings[name] = binding;
+            bind();
+        }
+
+        ~UniformBlock()
+        {
+            if (ubo) gl::deleteBuffer(ubo);
+        }
+
+        UniformBlock(const UniformBlock&) = delete;
+        UniformBlock& operator=(const UniformBlock&) = delete;
+
+        UniformBlock(UniformBlock&& other) noexcept
+            : ubo(other.ubo), binding(other.binding), value(other.value), uploaded(other.uploaded)
+        {
+            other.ubo = 0;
+            other.uploaded = false;
+        }
+
+        UniformBlock& operator=(UniformBlock&& other) noexcept
+        {
+            if (this != &other) {
+                if (ubo) gl::deleteBuffer(ubo);
+                ubo = other.ubo;
+                binding = other.binding;
+                value = other.value;
+                uploaded = other.uploaded;
+                other.ubo = 0;
+                other.uploaded = false;
+            }
+            return *this;
+        }
+
+        // Uploads only when the contents changed since the last set()
+        void set(const T& data)
+        {
+            if (!ubo) return;
+            if (uploaded && std::memcmp(&value, &data, sizeof(T)) == 0) return;
+
+            value = data;
+            uploaded = true;
+
+            // Respecified rather than overwritten, so frames still in flight
+            // keep reading the old contents instead of stalling the upload
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ubo);
+            glBufferData(GL_COPY_WRITE_BUFFER, sizeof(T), &value, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+
+        const T& get() const { return value; }
+
+        void bind() const
+        {
+            if (ubo) gl::bindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+        }
+
+        GLuint getBinding() const { return binding; }
+        GLuint getBuffer() const { return ubo; }
+
+    private:
+        GLuint ubo = 0;
+        GLuint binding = 0;
+        T value{};
+        bool uploaded = false;
+    };
+}
@@ -1,6 +1,7 @@
 #include "vertexlayout.h"
 #include "vectors.h"
 #include <cstring>
+#include <functional>
 
 size_t kern::VertexElement::getSize() const {
     switch (type) {
@@ -8,6 +9,7 @@ size_t kern::VertexElement::getSize() const {
         case VertexElementType::Float2:   return sizeof(float) * 2;
         case VertexElementType::Float3:   return sizeof(float) * 3;
         case VertexElementType::Float4:   return sizeof(float) * 4;
+        case VertexElementType::Mat4:     return sizeof(float) * 16;
         default: return 0;
     }
 }
@@ -18,27 +20,99 @@ size_t kern::VertexElement::getTypeComponentCount() const {
         case VertexElementType::Float2:   return 2;
         case VertexElementType::Float3:   return 3;
         case VertexElementType::Float4:   return 4;
+        case VertexElementType::Mat4:     return 4;
         default: return 0;
     }
 }
 
+int kern::VertexElement::getLocationCount() const {
+    return type == VertexElementType::Mat4 ? 4 : 1;
+}
+
+namespace {
+    void hashCombine(size_t& seed, size_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+}
+
+bool kern::VertexLayout::operator==(const VertexLayout& other) const {
+    if (hash != other.hash || stride != other.stride || instanceStride != other.instanceStride ||
+        elements.size() != other.elements.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < elements.size(); i++) {
+        const VertexElement& a = elements[i];
+        const VertexElement& b = other.elements[i];
+        if (a.type != b.type || a.offset != b.offset || a.index != b.index || a.divisor != b.divisor || a.name != b.name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+kern::VertexLayout& kern::VertexLayout::push(const std::string& name, VertexElementType type, unsigned int divisor) {
+    size_t& streamStride = divisor ? instanceStride : stride;
+
+    elements.push_back({ name, type, streamStride, nextLocation, divisor });
+    const VertexElement& elem = elements.back();
+
+    hashCombine(hash, std::hash<std::string>{}(elem.name));
+    hashCombine(hash, static_cast<size_t>(elem.type));
+    hashCombine(hash, elem.offset);
+    hashCombine(hash, static_cast<size_t>(elem.index));
+    hashCombine(hash, elem.divisor);
+
+    streamStride += elem.getSize();
+    nextLocation += elem.getLocationCount();
+    return *this;
+}
+
 template<>
 kern::VertexLayout& kern::VertexLayout::add<kern::Vector2>(const std::string& name) {
-    elements.push_back({ name, VertexElementType::Float2, stride, static_cast<int>(elements.size()) });
-    stride += sizeof(kern::Vector2);
-    return *this;
+    return push(name, VertexElementType::Float2, 0);
 }
 
 template<>
 kern::VertexLayout& kern::VertexLayout::add<kern::Vector3>(const std::string& name) {
-    elements.push_back({ name, VertexElementType::Float3, stride, static_cast<int>(elements.size()) });
-    stride += sizeof(kern::Vector3);
-    return *this;
+    return push(name, VertexElementType::Float3, 0);
 }
 
 template<>
 kern::VertexLayout& kern::VertexLayout::add<float>(const std::string& name) {
-    elements.push_back({ name, VertexElementType::Float, stride, static_cast<int>(elements.size()) });
-    stride += sizeof(float);
-    return *this;
-}
\ No newline at end of file
+    return push(name, VertexElementType::Float, 0);
+}
+
+template<>
+kern::VertexLayout& kern::VertexLayout::add<kern::Color>(const std::string& name) {
+    return push(name, VertexElementType::Float4, 0);
+}
+
+template<>
+kern::VertexLayout& kern::VertexLayout::add<kern::Mat4>(const std::string& name) {
+    return push(name, VertexElementType::Mat4, 0);
+}
+
+template<>
+kern::VertexLayout& kern::VertexLayout::addInstanced<kern::Vector2>(const std::string& name) {
+    return push(name, VertexElementType::Float2, 1);
+}
+
+template<>
+kern::VertexLayout& kern::VertexLayout::addInstanced<kern::Vector3>(const std::string& name) {
+    return push(name, VertexElementType::Float3, 1);
+}
+
+template<>
+kern::VertexLayout& kern::VertexLayout::addInstanced<float>(const std::string& name) {
+    return push(name, VertexElementType::Float, 1);
+}
+
+template<>
+kern::VertexLayout& kern::VertexLayout::addInstanced<kern::Color>(const std::string& name) {
+    return push(name, VertexElementType::Float4, 1);
+}
+
+template<>
+kern::VertexLayout& kern::VertexLayout::addInstanced<kern::Mat4>(const std::string& name) {
+    return push(name, VertexElementType::Mat4, 1);
+}
@@ -3,42 +3,74 @@
 #include <vector>
 #include <string>
 #include "vectors.h"
+#include "colors.h"
+#include "kernmath.h"
 
 namespace kern {
 
 enum class VertexElementType {
-    Float, Float2, Float3, Float4
+    Float, Float2, Float3, Float4, Mat4
 };
 
 struct VertexElement {
     std::string name;
     VertexElementType type;
-    size_t offset;
-    int index; 
+    size_t offset;  // Within its own stream (per-vertex or per-instance)
+    int index;      // First attribute location
+    unsigned int divisor; // 0 = per-vertex, 1 = advances once per instance
 
-    VertexElement(const std::string& name, VertexElementType type, size_t offset, int index)
-        : name(name), type(type), offset(offset), index(index) {}
+    VertexElement(const std::string& name, VertexElementType type, size_t offset, int index, unsigned int divisor = 0)
+        : name(name), type(type), offset(offset), index(index), divisor(divisor) {}
 
     size_t getSize() const;
-    size_t getTypeComponentCount() const;
+    size_t getTypeComponentCount() const; // Per attribute location
+    int getLocationCount() const;         // Mat4 spans 4 locations
+    bool isPerInstance() const { return divisor != 0; }
 };
 
+// Describes how a shader's inputs are laid out in memory. Elements added with
+// addInstanced() come from a second, per-instance stream with its own stride;
+// attribute locations keep counting across both.
 class VertexLayout {
 public:
     template<typename T>
     VertexLayout& add(const std::string& name);
 
+    template<typename T>
+    VertexLayout& addInstanced(const std::string& name);
+
     const std::vector<VertexElement>& getElements() const { return elements; }
     size_t getStride() const { return stride; }
+    size_t getInstanceStride() const { return instanceStride; }
+    bool hasInstanceElements() const { return instanceStride != 0; }
+    bool empty() const { return elements.empty(); }
+
+    // Covers every element (name, type, offset, index, divisor), not just the stride
+    size_t getHash() const { return hash; }
+
+    bool operator==(const VertexLayout& other) const;
 
 private:
     std::vector<VertexElement> elements;
     size_t stride = 0;
+    size_t instanceStride = 0;
+    int nextLocation = 0;
+    size_t hash = 0;
+
+    VertexLayout& push(const std::string& name, VertexElementType type, unsigned int divisor);
 };
 
 // Helper to register common types
 template<> VertexLayout& VertexLayout::add<Vector2>(const std::string& name);
 template<> VertexLayout& VertexLayout::add<Vector3>(const std::string& name);
 template<> VertexLayout& VertexLayout::add<float>(const std::string& name);
+template<> VertexLayout& VertexLayout::add<Color>(const std::string& name);
+template<> VertexLayout& VertexLayout::add<Mat4>(const std::string& name);
+
+template<> VertexLayout& VertexLayout::addInstanced<Vector2>(const std::string& name);
+template<> VertexLayout& VertexLayout::addInstanced<Vector3>(const std::string& name);
+template<> VertexLayout& VertexLayout::addInstanced<float>(const std::string& name);
+template<> VertexLayout& VertexLayout::addInstanced<Color>(const std::string& name);
+template<> VertexLayout& VertexLayout::addInstanced<Mat4>(const std::string& name);
 
 } // namespace kern